@@ -23,7 +23,7 @@ class MyceliaServer:
 
         self.node_types = ['shape', 'image', 'imageScale']
         self.texture_modes = ['align', 'rotate']
-        self.layout_types = {'static':0, 'dynamic':1}
+        self.layout_types = {'static':0, 'dynamic':1, 'multilevel':2, 'stress':3, 'components':4}
 
         self.graph_attrs = [
             'texture_mode',
@@ -86,6 +86,15 @@ class MyceliaServer:
             r,g,b,a = c.colorConverter.to_rgba(color)
             self.server.set_edge_color(myid, r, g, b, a)
 
+    def begin(self):
+        """
+        Starts a transaction. The display does not change until the
+        matching commit(), which shows all changes at once. A transaction
+        left open for 30 seconds is committed by the server.
+
+        """
+        self.server.begin()
+
     def center(self):
         self.server.center()
 
@@ -96,6 +105,9 @@ class MyceliaServer:
     def clear_velocities(self):
         self.server.clear_velocities()
 
+    def commit(self):
+        self.server.commit()
+
     def draw(self):
         self.server.draw()
 
@@ -120,7 +132,7 @@ class MyceliaServer:
 
     def set_layout_type(self, layout):
         if layout not in self.layout_types:
-            raise Exception("Layout should be 'static' or 'dynamic'.")
+            raise Exception("Layout should be 'static', 'dynamic', 'multilevel', 'stress' or 'components'.")
         else:
             self.server.set_layout_type(self.layout_types[layout])
 
@@ -140,6 +152,16 @@ class MyceliaServer:
         else:
             self.server.set_texture_node_mode(mode)
 
+    def set_thread_count(self, n):
+        self.server.set_thread_count(int(n))
+
+    def set_seed(self, seed):
+        # a string carries seeds past the 32 bit XML-RPC int
+        self.server.set_seed(str(int(seed)))
+
+    def set_settled_callback(self, url, method):
+        self.server.set_settled_callback(url, method)
+
 
 
 
@@ -181,8 +203,12 @@ class Graph(nx.Graph, MyceliaServer):
 
     def add_nodes_from(self, nodes, **attr):
         self.stop_layout()
-        for n in nodes:
-            self.add_node(n, stop=False, **attr)
+        self.begin()
+        try:
+            for n in nodes:
+                self.add_node(n, stop=False, **attr)
+        finally:
+            self.commit()
         self.resume_layout()
 
     def remove_node(self,n, stop=True):
@@ -197,8 +223,12 @@ class Graph(nx.Graph, MyceliaServer):
 
     def remove_nodes_from(self, nodes):
         self.stop_layout()
-        for n in nodes:
-            self.remove_node(n, stop=False)
+        self.begin()
+        try:
+            for n in nodes:
+                self.remove_node(n, stop=False)
+        finally:
+            self.commit()
         self.resume_layout()
 
     def add_edge(self, u, v, attr_dict=None, stop=True, **attr):
@@ -229,9 +259,13 @@ class Graph(nx.Graph, MyceliaServer):
 
     def add_edges_from(self, ebunch, attr_dict=None, stop=False, **attr):
         self.stop_layout()
-        for e in ebunch:
-            u,v=e[0:2]
-            self.add_edge(u,v,attr_dict=attr_dict,**attr)
+        self.begin()
+        try:
+            for e in ebunch:
+                u,v=e[0:2]
+                self.add_edge(u,v,attr_dict=attr_dict,**attr)
+        finally:
+            self.commit()
         self.resume_layout()
 
     def remove_edge(self, u, v, stop=True):
@@ -248,9 +282,13 @@ class Graph(nx.Graph, MyceliaServer):
 
     def remove_edges_from(self, ebunch):
         self.stop_layout()
-        for e in ebunch:
-            u,v=e[0:2]
-            self.remove_edge(u,v, stop=False)
+        self.begin()
+        try:
+            for e in ebunch:
+                u,v=e[0:2]
+                self.remove_edge(u,v, stop=False)
+        finally:
+            self.commit()
         self.resume_layout()
 
 
@@ -289,8 +327,12 @@ class DiGraph(nx.DiGraph, MyceliaServer):
         return myid
 
     def add_nodes_from(self, nodes, **attr):
-        for n in nodes:
-            self.add_node(n, **attr)
+        self.begin()
+        try:
+            for n in nodes:
+                self.add_node(n, **attr)
+        finally:
+            self.commit()
 
     def remove_node(self,n):
         myid = self.node[n].get(self.myid, None)
@@ -299,8 +341,12 @@ class DiGraph(nx.DiGraph, MyceliaServer):
             self.server.delete_node(myid)
 
     def remove_nodes_from(self, nodes):
-        for n in nodes:
-            self.remove_node(n)
+        self.begin()
+        try:
+            for n in nodes:
+                self.remove_node(n)
+        finally:
+            self.commit()
 
     def add_edge(self, u, v, attr_dict=None, **attr):
         if self.has_edge(u,v):
@@ -321,9 +367,13 @@ class DiGraph(nx.DiGraph, MyceliaServer):
 
 
     def add_edges_from(self, ebunch, attr_dict=None, **attr):
-        for e in ebunch:
-            u,v=e[0:2]
-            self.add_edge(u,v,attr_dict=attr_dict,**attr)
+        self.begin()
+        try:
+            for e in ebunch:
+                u,v=e[0:2]
+                self.add_edge(u,v,attr_dict=attr_dict,**attr)
+        finally:
+            self.commit()
 
     def remove_edge(self, u, v):
         myid_u = self.node[u][self.myid]
@@ -333,8 +383,12 @@ class DiGraph(nx.DiGraph, MyceliaServer):
             self.server.delete_edge(myid_u, myid_v)
 
     def remove_edges_from(self, ebunch):
-        for e in ebunch:
-            u,v=e[0:2]
-            self.remove_edge(u,v)
+        self.begin()
+        try:
+            for e in ebunch:
+                u,v=e[0:2]
+                self.remove_edge(u,v)
+        finally:
+            self.commit()
 
 
@@ -0,0 +1,219 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <batchlayout.hpp>
+
+using namespace std;
+
+/*
+ * stand-in application
+ */
+Mycelia::Mycelia(int threadCount)
+  : finished(false),
+    skipLayout(false)
+{
+    threadPool = new ThreadPool(threadCount);
+    g = new Graph(this);
+    positionBuffer = new PositionBuffer();
+}
+
+Mycelia::~Mycelia()
+{
+    delete g;
+    delete positionBuffer;
+    delete threadPool;
+}
+
+void Mycelia::layoutFinished() const
+{
+    finishedMutex.lock();
+    finished = true;
+    finishedCond.signal();
+    finishedMutex.unlock();
+}
+
+void Mycelia::layoutSettled() const
+{
+    layoutFinished();
+}
+
+// Blocks until the running layout finishes or settles.
+void Mycelia::waitForLayout() const
+{
+    finishedMutex.lock();
+
+    while(!finished)
+    {
+        finishedCond.wait(finishedMutex);
+    }
+
+    finished = false;
+    finishedMutex.unlock();
+}
+
+/*
+ * batch layout
+ */
+int main(int argc, char** argv)
+{
+    int type = LAYOUT_MULTILEVEL;
+    int threadCount = ThreadPool::getDefaultThreadCount();
+    int steps = BATCH_STEPS;
+    bool cache = false;
+    string input;
+    string output;
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-layout") == 0 && i < argc - 1)
+        {
+            string name = argv[++i];
+
+            if(name == "static") type = LAYOUT_STATIC;
+            else if(name == "dynamic") type = LAYOUT_DYNAMIC;
+            else if(name == "multilevel") type = LAYOUT_MULTILEVEL;
+            else if(name == "stress") type = LAYOUT_STRESS;
+            else if(name == "components") type = LAYOUT_COMPONENTS;
+            else
+            {
+                cout << BATCH_USAGE << endl;
+                return 1;
+            }
+        }
+        else if(strcmp(argv[i], "-threads") == 0 && i < argc - 1)
+        {
+            threadCount = max(1, atoi(argv[++i]));
+        }
+        else if(strcmp(argv[i], "-steps") == 0 && i < argc - 1)
+        {
+            steps = max(1, atoi(argv[++i]));
+        }
+        else if(strcmp(argv[i], "-seed") == 0 && i < argc - 1)
+        {
+            VruiHelp::seedRandom(strtoull(argv[++i], 0, 10));
+        }
+        else if(strcmp(argv[i], "-o") == 0 && i < argc - 1)
+        {
+            output = argv[++i];
+        }
+        else if(strcmp(argv[i], "-cache") == 0)
+        {
+            cache = true;
+        }
+        else if(argv[i][0] != '-' && input.empty())
+        {
+            input = argv[i];
+        }
+        else
+        {
+            cout << BATCH_USAGE << endl;
+            return 1;
+        }
+    }
+
+    if(input.empty() || (output.empty() && !cache))
+    {
+        cout << BATCH_USAGE << endl;
+        return 1;
+    }
+
+    Mycelia app(threadCount);
+
+    // parse
+    if(VruiHelp::endsWith(input, ".dot"))
+    {
+        DotParser(&app).parse(input);
+    }
+    else if(VruiHelp::endsWith(input, ".xml"))
+    {
+        XmlParser(&app).parse(input);
+    }
+    else if(VruiHelp::endsWith(input, ".chaco"))
+    {
+        ChacoParser(&app).parse(input);
+    }
+    else if(VruiHelp::endsWith(input, ".gml"))
+    {
+        GmlParser(&app).parse(input);
+    }
+    else
+    {
+        cout << "unknown format " << input << endl;
+        return 1;
+    }
+
+    if(app.g->getNodeCount() == 0)
+    {
+        cout << "no nodes in " << input << endl;
+        return 1;
+    }
+
+    FruchtermanReingoldLayout staticLayout(&app);
+    ArfLayout dynamicLayout(&app);
+    MultilevelLayout multilevelLayout(&app);
+    StressLayout stressLayout(&app);
+    ComponentLayout componentLayout(&app);
+    GraphLayout* layout = &multilevelLayout;
+
+    if(type == LAYOUT_STATIC) layout = &staticLayout;
+    else if(type == LAYOUT_DYNAMIC) layout = &dynamicLayout;
+    else if(type == LAYOUT_STRESS) layout = &stressLayout;
+    else if(type == LAYOUT_COMPONENTS) layout = &componentLayout;
+
+    // the dynamic layout only returns once it settles, bound it
+    dynamicLayout.setStepLimit(steps);
+
+    // same start as the viewer's reset, minus the cache lookup
+    if(!app.getSkipLayout())
+    {
+        bool placed = PivotMds(&app).place();
+
+        if(!placed)
+        {
+            app.g->randomizePositions(100);
+        }
+
+        staticLayout.setWarmStart(placed);
+        app.g->clearVelocities();
+
+        layout->start();
+        app.waitForLayout();
+        layout->stop();
+    }
+
+    // write
+    LayoutCache layoutCache(&app);
+
+    if(cache)
+    {
+        vector<double> parameters(1, type);
+        layout->getParameters(parameters);
+        layoutCache.store(input, parameters);
+    }
+
+    if(VruiHelp::endsWith(output, ".dot"))
+    {
+        app.g->write(output.c_str());
+    }
+    else if(!output.empty() && !layoutCache.write(output))
+    {
+        return 1;
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,42 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BATCHLAYOUT_HPP
+#define __BATCHLAYOUT_HPP
+
+#include <graph.hpp>
+#include <mycelia.hpp>
+#include <positionbuffer.hpp>
+#include <threadpool.hpp>
+#include <vruihelp.hpp>
+#include <layout/arflayout.hpp>
+#include <layout/componentlayout.hpp>
+#include <layout/frlayout.hpp>
+#include <layout/layoutcache.hpp>
+#include <layout/multilevellayout.hpp>
+#include <layout/pivotmds.hpp>
+#include <layout/stresslayout.hpp>
+#include <parsers/chacoparser.hpp>
+#include <parsers/dotparser.hpp>
+#include <parsers/gmlparser.hpp>
+#include <parsers/xmlparser.hpp>
+
+#define BATCH_STEPS 5000 // dynamic layout steps when it does not settle first
+#define BATCH_USAGE "usage: mycelia-layout [-layout static|dynamic|multilevel|stress|components] [-threads n] [-seed n] [-steps n] [-cache] [-o out.dot|out.bin] graph"
+
+#endif
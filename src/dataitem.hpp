@@ -21,9 +21,114 @@
 
 #include <mycelia.hpp>
 
+#include <cstddef>
 #include <map>
 #include <vector>
 
+// one corner of a shape node's impostor quad
+struct NodeVertex
+{
+    GLfloat corner[3]; // quad corner in [-1, 1]^2 and node radius
+    GLubyte color[4];
+    GLfloat position[3];
+};
+
+// one corner of an edge piece's impostor quad
+struct EdgeVertex
+{
+    GLfloat side[2]; // -1 or 1 across the piece, and its radius at this end
+    GLfloat axis[3]; // from the piece's start to its end
+    GLubyte color[4];
+    GLfloat position[3];
+};
+
+// What an edge draws, fixed until the graph changes. Positions are looked
+// up again whenever they move.
+struct EdgeRecord
+{
+    int edge;
+    int source;
+    int target;
+    GLubyte color[4];
+    GLfloat radius;
+    GLfloat sourceOffset; // room left at each end for the node
+    GLfloat targetOffset;
+    bool bidirectional;
+};
+
+/*
+ * Shape nodes are drawn as sphere impostors: a camera facing quad per node
+ * whose fragments are shaded and depth corrected as the sphere behind them.
+ * Edges and arrow heads are quads widened across the view and shaded as
+ * the cylinder or cone they stand for. Radii are scaled by the modelview,
+ * which Vrui keeps uniform. Both take the first light, Vrui's headlight.
+ */
+#define IMPOSTOR_SHADE \
+    "    vec4 light = gl_LightSource[0].position;\n" \
+    "    float diffuse = max(dot(normal, normalize(light.xyz - eye * light.w)), 0.0);\n" \
+    "    vec4 shade = gl_LightModel.ambient + gl_LightSource[0].ambient + gl_LightSource[0].diffuse * diffuse;\n" \
+    "    gl_FragColor = vec4(gl_Color.rgb * shade.rgb, gl_Color.a);\n"
+
+#define NODE_VERTEX_SHADER \
+    "varying vec2 corner;\n" \
+    "varying vec3 center;\n" \
+    "varying float radius;\n" \
+    "void main()\n" \
+    "{\n" \
+    "    vec4 eye = gl_ModelViewMatrix * gl_Vertex;\n" \
+    "    corner = gl_MultiTexCoord0.xy;\n" \
+    "    radius = gl_MultiTexCoord0.z * length(gl_ModelViewMatrix[0].xyz);\n" \
+    "    center = eye.xyz / eye.w;\n" \
+    "    gl_FrontColor = gl_Color;\n" \
+    "    gl_Position = gl_ProjectionMatrix * vec4(center + vec3(corner * radius, 0.0), 1.0);\n" \
+    "}\n"
+
+#define NODE_FRAGMENT_SHADER \
+    "varying vec2 corner;\n" \
+    "varying vec3 center;\n" \
+    "varying float radius;\n" \
+    "void main()\n" \
+    "{\n" \
+    "    float d = dot(corner, corner);\n" \
+    "    if(d > 1.0) discard;\n" \
+    "    vec3 normal = vec3(corner, sqrt(1.0 - d));\n" \
+    "    vec3 eye = center + normal * radius;\n" \
+    "    vec4 clip = gl_ProjectionMatrix * vec4(eye, 1.0);\n" \
+    "    gl_FragDepth = 0.5 * (gl_DepthRange.diff * clip.z / clip.w + gl_DepthRange.near + gl_DepthRange.far);\n" \
+    IMPOSTOR_SHADE \
+    "}\n"
+
+#define EDGE_VERTEX_SHADER \
+    "varying float across;\n" \
+    "varying vec3 side;\n" \
+    "varying vec3 toEye;\n" \
+    "varying vec3 eye;\n" \
+    "void main()\n" \
+    "{\n" \
+    "    vec4 p = gl_ModelViewMatrix * gl_Vertex;\n" \
+    "    vec3 axis = (gl_ModelViewMatrix * vec4(gl_Normal, 0.0)).xyz;\n" \
+    "    float radius = gl_MultiTexCoord0.y * length(gl_ModelViewMatrix[0].xyz);\n" \
+    "    eye = p.xyz / p.w;\n" \
+    "    toEye = normalize(-eye);\n" \
+    "    vec3 c = cross(axis, toEye);\n" \
+    "    side = length(c) > 0.0 ? normalize(c) : vec3(1.0, 0.0, 0.0);\n" \
+    "    across = gl_MultiTexCoord0.x;\n" \
+    "    eye += side * across * radius;\n" \
+    "    gl_FrontColor = gl_Color;\n" \
+    "    gl_Position = gl_ProjectionMatrix * vec4(eye, 1.0);\n" \
+    "}\n"
+
+#define EDGE_FRAGMENT_SHADER \
+    "varying float across;\n" \
+    "varying vec3 side;\n" \
+    "varying vec3 toEye;\n" \
+    "varying vec3 eye;\n" \
+    "void main()\n" \
+    "{\n" \
+    "    vec3 normal = normalize(side * across + toEye * sqrt(max(1.0 - across * across, 0.0)));\n" \
+    IMPOSTOR_SHADE \
+    "}\n"
+
 class MyceliaDataItem : public GLObject::DataItem
 {
 public:
@@ -36,6 +141,20 @@ public:
     GLuint graphList;
     GLuint nodeList;
 
+    // Shape nodes and edges. The records are rebuilt when gCopy's graph
+    // changes, the vertices are refilled from them when positions move.
+    bool impostors; // false if the context lacks shaders or buffers
+    GLShader nodeShader;
+    GLShader edgeShader;
+    GLuint nodeBuffer;
+    GLuint edgeBuffer;
+    std::vector<int> bufferNodes; // node of each quad
+    std::vector<EdgeRecord> bufferEdges;
+    std::vector<NodeVertex> nodeVertices;
+    std::vector<EdgeVertex> edgeVertices;
+    int bufferGraphVersion;
+    int bufferPositionVersion;
+
     // cached images
     std::map<std::string, size_t> textureIndexMap;
     std::map<std::string, std::pair<int, int> > textureSizeMap;
@@ -63,7 +182,35 @@ public:
         textureIds.resize(1000); // reserve 1000 textures
         glGenTextures(1000, &textureIds[0]);
 
-        graphListVersion = 0;
+        graphListVersion = -1;
+
+        impostors = false;
+        nodeBuffer = 0;
+        edgeBuffer = 0;
+        bufferGraphVersion = -1;
+        bufferPositionVersion = -1;
+
+        if(GLARBVertexBufferObject::isSupported() && GLShader::isSupported())
+        {
+            GLARBVertexBufferObject::initExtension();
+            glGenBuffersARB(1, &nodeBuffer);
+            glGenBuffersARB(1, &edgeBuffer);
+
+            try
+            {
+                nodeShader.compileVertexShaderFromString(NODE_VERTEX_SHADER);
+                nodeShader.compileFragmentShaderFromString(NODE_FRAGMENT_SHADER);
+                nodeShader.linkShader();
+                edgeShader.compileVertexShaderFromString(EDGE_VERTEX_SHADER);
+                edgeShader.compileFragmentShaderFromString(EDGE_FRAGMENT_SHADER);
+                edgeShader.linkShader();
+                impostors = true;
+            }
+            catch(std::exception& e)
+            {
+                std::cerr << "Drawing the graph without impostors: " << e.what() << std::endl;
+            }
+        }
     }
 
     ~MyceliaDataItem()
@@ -77,6 +224,12 @@ public:
         glDeleteLists(graphList, 1);
         glDeleteLists(nodeList, 1);
         glDeleteTextures(textureIds.size(), &textureIds[0]);
+
+        if(nodeBuffer != 0)
+        {
+            glDeleteBuffersARB(1, &nodeBuffer);
+            glDeleteBuffersARB(1, &edgeBuffer);
+        }
     }
 
     TexturePair getTextureId(std::string imagePath)
@@ -34,20 +34,22 @@ void BarabasiGenerator::generate() const
 void BarabasiGenerator::generateNodes(int nodeCount) const
 {
     application->g->clear();
-    
-    for(int i = 0; i < nodeCount; i++)
-    {
-        application->g->addNode();
-    }
+    application->g->addNodes(nodeCount);
 }
 
 void BarabasiGenerator::generateEdges(int initialNodeCount, int maxNodeCount) const
 {
     application->g->clearEdges();
     
+    // degrees are tracked here so the edges can be added in one batch
+    vector<pair<int, int> > edges;
+    vector<int> degrees(maxNodeCount);
+    
     for(int i = 0; i < initialNodeCount; i++)
     {
-        application->g->addEdge(i, (i + 1) % initialNodeCount);
+        edges.push_back(pair<int, int>(i, (i + 1) % initialNodeCount));
+        degrees[i]++;
+        degrees[(i + 1) % initialNodeCount]++;
     }
     
     for(int sourceNode = initialNodeCount; sourceNode < maxNodeCount; sourceNode++)
@@ -56,12 +58,16 @@ void BarabasiGenerator::generateEdges(int initialNodeCount, int maxNodeCount) co
         {
             if(sourceNode == candidateNode) continue;
             
-            float p_i = (float)application->g->getNodeDegree(candidateNode) / application->g->getEdgeCount();
+            float p_i = (float)degrees[candidateNode] / edges.size();
             
             if(VruiHelp::randomFloat() < p_i)
             {
-                application->g->addEdge(sourceNode, candidateNode);
+                edges.push_back(pair<int, int>(sourceNode, candidateNode));
+                degrees[sourceNode]++;
+                degrees[candidateNode]++;
             }
         }
     }
+    
+    application->g->addEdges(edges);
 }
\ No newline at end of file
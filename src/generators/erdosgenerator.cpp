@@ -36,16 +36,13 @@ void ErdosGenerator::generate() const
 void ErdosGenerator::generateNodes(int nodeCount) const
 {
     application->g->clear();
-    
-    for(int i = 0; i < nodeCount; i++)
-    {
-        application->g->addNode();
-    }
+    application->g->addNodes(nodeCount);
 }
 
 void ErdosGenerator::generateEdges(float p) const
 {
     application->g->clearEdges();
+    vector<pair<int, int> > edges;
     
     foreach(int sourceNode, application->g->getNodes())
     {
@@ -55,8 +52,10 @@ void ErdosGenerator::generateEdges(float p) const
             
             if(VruiHelp::randomFloat() < p)
             {
-                application->g->addEdge(sourceNode, candidateNode);
+                edges.push_back(pair<int, int>(sourceNode, candidateNode));
             }
         }
     }
+    
+    application->g->addEdges(edges);
 }
\ No newline at end of file
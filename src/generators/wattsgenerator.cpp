@@ -34,33 +34,26 @@ void WattsGenerator::generate() const
 void WattsGenerator::generateNodes(int nodeCount) const
 {
     application->g->clear();
-    
-    for(int i = 0; i < nodeCount; i++)
-    {
-        application->g->addNode();
-    }
+    application->g->addNodes(nodeCount);
 }
 
 void WattsGenerator::generateEdges(int nodeCount, float beta) const
 {
     application->g->clearEdges();
+    vector<pair<int, int> > edges(nodeCount);
     
     for(int i = 0; i < nodeCount; i++)
     {
-        application->g->addEdge(i, (i + 1) % nodeCount);
+        edges[i] = pair<int, int>(i, (i + 1) % nodeCount);
     }
     
-    set<int> edgesCopy = application->g->getEdges();
-    
     // this is probably not correct
-    foreach(int edge, edgesCopy)
+    for(int i = 0; i < nodeCount; i++)
     {
-        const Edge& e = application->g->getEdge(edge);
-        int node = e.source;
+        int node = edges[i].first;
         
         if(VruiHelp::randomFloat() < beta)
         {
-            application->g->deleteEdge(edge);
             int candidateNode;
             
             do
@@ -69,7 +62,9 @@ void WattsGenerator::generateEdges(int nodeCount, float beta) const
             }
             while(node == candidateNode);
             
-            application->g->addEdge(node, candidateNode);
+            edges[i].second = candidateNode;
         }
     }
+    
+    application->g->addEdges(edges);
 }
\ No newline at end of file
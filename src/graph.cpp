@@ -20,7 +20,13 @@
 
 using namespace std;
 
-Graph::Graph(Mycelia* application): application(application)
+Graph::Graph(Mycelia* application)
+    : application(application),
+      version(0),
+      transactionDepth(0),
+      transactionModified(false),
+      transactionWake(false),
+      floating(false)
 {
     init();
 }
@@ -30,14 +36,19 @@ Graph& Graph::operator=(const Graph& g)
     application = g.application;
     version = g.version;
 
-    nodes = g.nodes;
-    nodeMap = g.nodeMap;
-
-    edges = g.edges;
-    edgeMap = g.edgeMap;
+    // materials are only ever appended, the current list covers both states
+    if(g.transactionDepth > 0)
+    {
+        store = g.committedStore;
+        textureNodeMode = g.committedTextureNodeMode;
+    }
+    else
+    {
+        store = g.store;
+        textureNodeMode = g.textureNodeMode;
+    }
 
     materialVector = g.materialVector;
-    textureNodeMode = g.textureNodeMode;
 
     return *this;
 }
@@ -45,6 +56,81 @@ Graph& Graph::operator=(const Graph& g)
 /*
  * general
  */
+// Transactions nest; only the outermost commit publishes. Changes made in
+// between are visible to layouts right away but reach the renderer together,
+// with a single version increment.
+void Graph::begin()
+{
+    mutex.lock();
+
+    if(transactionDepth++ == 0)
+    {
+        committedStore = store;
+        committedTextureNodeMode = textureNodeMode;
+        transactionModified = false;
+        transactionWake = false;
+        transactionStart = time(0);
+    }
+
+    mutex.unlock();
+
+#ifndef __HEADLESS__
+    Vrui::requestUpdate(); // frames check for expired transactions
+#endif
+}
+
+void Graph::commit()
+{
+    mutex.lock();
+
+    if(transactionDepth == 0)
+    {
+        mutex.unlock();
+        return;
+    }
+
+    bool modified = false;
+
+    if(--transactionDepth == 0)
+    {
+        committedStore = GraphStore(); // drop the shared arrays
+        modified = transactionModified;
+    }
+
+    bool wake = transactionWake;
+
+    mutex.unlock();
+
+    if(modified) bumpVersion(wake);
+}
+
+// A client that began a transaction and went away would hold back every
+// change for good, so after TRANSACTION_TIMEOUT the transaction, nested or
+// not, is committed anyway. Returns true while one is still open.
+const bool Graph::expireTransaction()
+{
+    mutex.lock();
+
+    bool open = transactionDepth > 0;
+    bool expired = open && time(0) - transactionStart >= TRANSACTION_TIMEOUT;
+
+    if(expired)
+    {
+        cout << "transaction open for " << TRANSACTION_TIMEOUT << "s, committing" << endl;
+        transactionDepth = 1;
+    }
+
+    mutex.unlock();
+
+    if(expired)
+    {
+        commit();
+        return false;
+    }
+
+    return open;
+}
+
 void Graph::clear()
 {
     application->stopLayout();
@@ -53,6 +139,7 @@ void Graph::clear()
     init();
 
     mutex.unlock();
+    update();
     application->clearSelections();
 }
 
@@ -60,9 +147,9 @@ void Graph::clearVelocities()
 {
     mutex.lock();
 
-    foreach(int node, nodes)
+    foreach(int node, store.getNodes())
     {
-        nodeMap[node].velocity = Vrui::Vector(0, 0, 0);
+        store.velocity(node) = Vrui::Vector(0, 0, 0);
     }
 
     mutex.unlock();
@@ -70,13 +157,7 @@ void Graph::clearVelocities()
 
 void Graph::init()
 {
-    nodes.clear();
-    nodeMap.clear();
-    nodeMap.rehash(1000);
-
-    edges.clear();
-    edgeMap.clear();
-    edgeMap.rehash(1000);
+    store.clear();
 
     // TODO: Move back to dataitem.cpp
     materialVector.clear();
@@ -89,9 +170,10 @@ void Graph::init()
 
     textureNodeMode = "align";
 
-    version = -1;
-    nodeId = -1;
-    edgeId = -1;
+    floatingNodes.clear();
+    placedNodes.clear();
+    changedNodes.clear();
+    changedOverflow = true;
 
     lastCenter[0] = 0;
     lastCenter[1] = 0;
@@ -119,25 +201,27 @@ const pair<Vrui::Point, Vrui::Scalar> Graph::locate()
 
     mutex.lock();
 
-    foreach(int source, nodes)
+    const vector<Vrui::Point>& positions = store.getPositions();
+
+    foreach(int source, store.getNodes())
     {
         if(!application->isSelectedComponent(source))
         {
             continue;
         }
 
-        foreach(int target, nodes)
+        foreach(int target, store.getNodes())
         {
             if(!application->isSelectedComponent(target))
             {
                 continue;
             }
 
-            Vrui::Scalar d = Geometry::mag(nodeMap[source].position - nodeMap[target].position);
+            Vrui::Scalar d = Geometry::mag(positions[source] - positions[target]);
             if(d > maxDistance) maxDistance = d;
         }
 
-        center += (nodeMap[source].position - center) * (1.0 / counted);
+        center += (positions[source] - center) * (1.0 / counted);
 
         counted++;
     }
@@ -152,6 +236,21 @@ const pair<Vrui::Point, Vrui::Scalar> Graph::locate()
     return pair<Vrui::Point, Vrui::Scalar>(center, maxDistance);
 }
 
+// looks for the color in the cache and adds it if not found
+const int Graph::getMaterialId(const GLMaterial::Color& c)
+{
+    for(int i = 0; i < (int)materialVector.size(); i++)
+    {
+        if(materialVector[i]->ambient == c)
+        {
+            return i;
+        }
+    }
+
+    materialVector.push_back(new GLMaterial(c));
+    return materialVector.size() - 1;
+}
+
 const GLMaterial* Graph::getNodeMaterialFromId(int materialId)
 {
     if(materialId < 0 || materialId >= (int)materialVector.size())
@@ -192,18 +291,56 @@ void Graph::randomizePositions(Vrui::Scalar radius)
     mutex.lock();
 
     Vrui::Scalar x,y,z;
-    foreach(int node, nodes)
+    foreach(int node, store.getNodes())
     {
         x = radius * (2 * VruiHelp::randomFloat() - 1);
         y = radius * (2 * VruiHelp::randomFloat() - 1);
         z = radius * (2 * VruiHelp::randomFloat() - 1);
-        nodeMap[node].position = Vrui::Point(x, y, z);
+        store.position(node) = Vrui::Point(x, y, z);
     }
 
+    floatingNodes.clear();
+    placedNodes.clear();
+    changedOverflow = true;
+
     mutex.unlock();
     update();
 }
 
+// Publishes a change, a settled layout resumes only if asked to. The version
+// is never reset, snapshots compare versions to detect changes.
+void Graph::bumpVersion(bool wake)
+{
+    mutex.lock();
+
+    if(transactionDepth > 0)
+    {
+        transactionModified = true;
+        transactionWake = transactionWake || wake;
+        mutex.unlock();
+        return;
+    }
+
+    version++;
+
+    mutex.unlock();
+
+#ifndef __HEADLESS__
+    Vrui::requestUpdate();
+#endif
+
+    if(wake && this == application->g)
+    {
+        application->wakeLayout();
+    }
+}
+
+// for changes the layout does not see: selection, colors, labels
+void Graph::redraw()
+{
+    bumpVersion(false);
+}
+
 void Graph::setTextureNodeMode(std::string& mode)
 {
     mutex.lock();
@@ -211,13 +348,13 @@ void Graph::setTextureNodeMode(std::string& mode)
     textureNodeMode = mode;
 
     mutex.unlock();
-    update();
+    redraw();
 }
 
+// for changes to topology or positions
 void Graph::update()
 {
-    version++;
-    Vrui::requestUpdate();
+    bumpVersion(true);
 }
 
 void Graph::write(const char* filename)
@@ -227,17 +364,26 @@ void Graph::write(const char* filename)
     ofstream out(filename);
     out << "digraph G {" << endl;
 
-    foreach(int node, nodes)
+    foreach(int node, store.getNodes())
     {
+        const Vrui::Point& p = store.getPosition(node);
         out << "  n" << node << "[ pos=\""
-            << nodeMap[node].position[0] << ","
-            << nodeMap[node].position[1] << ","
-            << nodeMap[node].position[2] << "\" ];\n";
+            << p[0] << ","
+            << p[1] << ","
+            << p[2] << "\"";
+
+        // the parser stops a label at the first quote
+        string label = store.getLabel(node);
+        replace(label.begin(), label.end(), '"', '\'');
+
+        if(!label.empty()) out << ", label=\"" << label << "\"";
+
+        out << " ];\n";
     }
 
-    foreach(int edge, edges)
+    foreach(int edge, store.getEdges())
     {
-        out << "  n" << edgeMap[edge].source << " -> n" << edgeMap[edge].target << ";\n";
+        out << "  n" << store.getEdge(edge).source << " -> n" << store.getEdge(edge).target << ";\n";
     }
 
     out << "}\n";
@@ -246,6 +392,298 @@ void Graph::write(const char* filename)
     mutex.unlock();
 }
 
+/*
+ * layout
+ */
+
+// Copies a published layout frame into this graph (the render copy). Frames
+// from another topology version are ignored, the next snapshot covers them.
+const bool Graph::readLayout(const PositionBuffer& buffer)
+{
+    if(buffer.getTag() != version || buffer.getCount() != store.getNodeCapacity())
+    {
+        return false;
+    }
+
+    const float* p = buffer.getPositions();
+    vector<Vrui::Point>& positions = store.editPositions();
+
+    foreach(int node, store.getNodes())
+    {
+        positions[node] = Vrui::Point(p[3 * node], p[3 * node + 1], p[3 * node + 2]);
+    }
+
+    return true;
+}
+
+// Hands the nodes touched since the last call to a layout and starts a new
+// list. Returns false if the list overflowed or the whole graph moved, the
+// layout must then treat every node as changed. Floating nodes placed by an
+// edge stop floating here, from now on the layout places them; unplaced
+// ones keep waiting for their first edge. Nothing is handed out while a
+// transaction is open, its changes arrive together after the commit.
+const bool Graph::takeChangedNodes(vector<int>& nodes)
+{
+    mutex.lock();
+
+    nodes.clear();
+
+    if(transactionDepth > 0)
+    {
+        mutex.unlock();
+        return true;
+    }
+
+    nodes.swap(changedNodes);
+    bool local = !changedOverflow;
+    changedOverflow = false;
+
+    foreach(int node, placedNodes)
+    {
+        floatingNodes.erase(node);
+    }
+
+    placedNodes.clear();
+
+    mutex.unlock();
+
+    return local;
+}
+
+// Only the dynamic layout takes floating nodes, others drop them.
+void Graph::setDynamicLayout(bool dynamic)
+{
+    mutex.lock();
+
+    floating = dynamic;
+
+    if(!floating)
+    {
+        floatingNodes.clear();
+        placedNodes.clear();
+    }
+
+    mutex.unlock();
+}
+
+// Applies one layout step and hands the positions to the renderer. The
+// version is left alone so motion alone never forces a full snapshot.
+void Graph::updateLayout(const vector<Vrui::Vector>& positionDeltas, const vector<Vrui::Vector>& velocityDeltas)
+{
+    mutex.lock();
+
+    vector<Vrui::Point>& positions = store.editPositions();
+
+    foreach(int node, store.getNodes())
+    {
+        if(node < (int)positionDeltas.size()) positions[node] += positionDeltas[node];
+    }
+
+    if(!velocityDeltas.empty())
+    {
+        vector<Vrui::Vector>& velocities = store.editVelocities();
+
+        foreach(int node, store.getNodes())
+        {
+            if(node < (int)velocityDeltas.size()) velocities[node] += velocityDeltas[node];
+        }
+    }
+
+    publishLayout();
+
+    mutex.unlock();
+
+#ifndef __HEADLESS__
+    Vrui::requestUpdate();
+#endif
+}
+
+// Like updateLayout, for layouts that compute whole positions. Nodes the
+// layout does not list keep theirs, edits made meanwhile are not undone
+// by stale deltas.
+void Graph::setLayoutPositions(const vector<int>& nodes, const vector<Vrui::Point>& layoutPositions)
+{
+    mutex.lock();
+
+    vector<Vrui::Point>& positions = store.editPositions();
+
+    for(int i = 0; i < (int)nodes.size(); i++)
+    {
+        if(store.isValidNode(nodes[i])) positions[nodes[i]] = layoutPositions[i];
+    }
+
+    publishLayout();
+
+    mutex.unlock();
+
+#ifndef __HEADLESS__
+    Vrui::requestUpdate();
+#endif
+}
+
+// Hands every position to the renderer as one frame, callers hold the mutex.
+void Graph::publishLayout()
+{
+    const vector<Vrui::Point>& positions = store.getPositions();
+    int capacity = store.getNodeCapacity();
+    float* p = application->positionBuffer->beginWrite(capacity);
+
+    for(int node = 0; node < capacity; node++)
+    {
+        p[3 * node] = positions[node][0];
+        p[3 * node + 1] = positions[node][1];
+        p[3 * node + 2] = positions[node][2];
+    }
+
+    application->positionBuffer->publish(version);
+}
+
+/*
+ * batch
+ */
+void Graph::reserve(int nodeCount, int edgeCount)
+{
+    mutex.lock();
+
+    store.reserve(nodeCount, edgeCount);
+
+    mutex.unlock();
+}
+
+const vector<int> Graph::addNodes(int count)
+{
+    vector<int> nodes(count);
+
+    mutex.lock();
+
+    for(int i = 0; i < count; i++)
+    {
+        nodes[i] = store.addNode(getNewNodePosition());
+        addFloating(nodes[i]);
+        markChanged(nodes[i]);
+    }
+
+    mutex.unlock();
+    update();
+
+    return nodes;
+}
+
+// invalid pairs get an edge id of -1
+const vector<int> Graph::addEdges(const vector<pair<int, int> >& pairs)
+{
+    vector<int> edges(pairs.size());
+
+    mutex.lock();
+
+    for(int i = 0; i < (int)pairs.size(); i++)
+    {
+        edges[i] = store.addEdge(pairs[i].first, pairs[i].second);
+
+        if(edges[i] == -1)
+        {
+            cout << "invalid node(s): " << pairs[i].first << " " << pairs[i].second << endl;
+            continue;
+        }
+
+        placeFloating(pairs[i].first, pairs[i].second);
+        placeFloating(pairs[i].second, pairs[i].first);
+        markChanged(pairs[i].first);
+        markChanged(pairs[i].second);
+    }
+
+    mutex.unlock();
+    update();
+
+    return edges;
+}
+
+void Graph::setEdgeLabels(const vector<int>& edges, const vector<string>& labels)
+{
+    mutex.lock();
+
+    for(int i = 0; i < (int)edges.size(); i++)
+    {
+        if(store.isValidEdge(edges[i])) store.edgeLabel(edges[i]) = labels[i];
+    }
+
+    mutex.unlock();
+    redraw();
+}
+
+// appends to each node's existing attributes
+void Graph::setNodeAttributes(const vector<int>& nodes, const vector<Attributes>& attributes)
+{
+    mutex.lock();
+
+    for(int i = 0; i < (int)nodes.size(); i++)
+    {
+        if(!store.isValidNode(nodes[i])) continue;
+
+        Attributes& a = store.attributeList(nodes[i]);
+        a.insert(a.end(), attributes[i].begin(), attributes[i].end());
+    }
+
+    mutex.unlock();
+    redraw();
+}
+
+void Graph::setNodeColors(const vector<int>& nodes, const vector<GLMaterial::Color>& colors)
+{
+    mutex.lock();
+
+    for(int i = 0; i < (int)nodes.size(); i++)
+    {
+        if(store.isValidNode(nodes[i])) store.material(nodes[i]) = getMaterialId(colors[i]);
+    }
+
+    mutex.unlock();
+    redraw();
+}
+
+void Graph::setNodeLabels(const vector<int>& nodes, const vector<string>& labels)
+{
+    mutex.lock();
+
+    for(int i = 0; i < (int)nodes.size(); i++)
+    {
+        if(store.isValidNode(nodes[i])) store.label(nodes[i]) = labels[i];
+    }
+
+    mutex.unlock();
+    redraw();
+}
+
+void Graph::setNodePositions(const vector<int>& nodes, const vector<Vrui::Point>& positions)
+{
+    mutex.lock();
+
+    for(int i = 0; i < (int)nodes.size(); i++)
+    {
+        if(!store.isValidNode(nodes[i])) continue;
+
+        store.position(nodes[i]) = positions[i];
+        floatingNodes.erase(nodes[i]);
+        markChanged(nodes[i]);
+    }
+
+    mutex.unlock();
+    update();
+}
+
+void Graph::setNodeSizes(const vector<int>& nodes, const vector<float>& sizes)
+{
+    mutex.lock();
+
+    for(int i = 0; i < (int)nodes.size(); i++)
+    {
+        if(store.isValidNode(nodes[i])) store.size(nodes[i]) = sizes[i];
+    }
+
+    mutex.unlock();
+    redraw();
+}
+
 /*
  * edges
  */
@@ -260,13 +698,12 @@ const int Graph::addEdge(int source, int target)
         return -1;
     }
 
-    edgeId++;
-    edges.insert(edgeId);
-    edgeMap[edgeId] = Edge(source, target);
+    int edgeId = store.addEdge(source, target);
 
-    nodeMap[source].outDegree++;
-    nodeMap[target].inDegree++;
-    nodeMap[source].adjacent[target].push_back(edgeId);
+    placeFloating(source, target);
+    placeFloating(target, source);
+    markChanged(source);
+    markChanged(target);
 
     mutex.unlock();
     update();
@@ -278,13 +715,7 @@ void Graph::clearEdges()
 {
     mutex.lock();
 
-    foreach(int node, nodes)
-    {
-        nodeMap[node].adjacent.clear();
-    }
-
-    edges.clear();
-    edgeMap.clear();
+    store.clearEdges();
 
     mutex.unlock();
     update();
@@ -300,12 +731,9 @@ const int Graph::deleteEdge(int edge)
         return -1;
     }
 
-    Edge& e = edgeMap[edge];
-    list<int>& neighbors = nodeMap[e.source].adjacent[e.target];
-    neighbors.erase(find(neighbors.begin(), neighbors.end(), edge));
-
-    edges.erase(edge);
-    edgeMap.erase(edge);
+    markChanged(store.getEdge(edge).source);
+    markChanged(store.getEdge(edge).target);
+    store.deleteEdge(edge);
 
     mutex.unlock();
     update();
@@ -315,50 +743,62 @@ const int Graph::deleteEdge(int edge)
 
 const Edge& Graph::getEdge(int edge)
 {
-    return edgeMap[edge];
+    return store.getEdge(edge);
 }
 
-const list<int>& Graph::getEdges(int source, int target)
+const IdRange Graph::getEdges(int source, int target)
 {
-    if(hasEdge(source, target))
-        return nodeMap[source].adjacent[target];
-
-    return empty;
+    return store.getEdges(source, target);
 }
 
 const std::string& Graph::getEdgeLabel(int edge)
 {
-    return edgeMap[edge].label;
+    return store.getEdgeLabel(edge);
 }
 
 const GLMaterial* Graph::getEdgeMaterial(int edge)
 {
-    return getEdgeMaterialFromId(edgeMap[edge].material);
+    return getEdgeMaterialFromId(store.getEdge(edge).material);
 }
 
 const float Graph::getEdgeWeight(int edge)
 {
-    return edgeMap[edge].weight;
+    return store.getEdge(edge).weight;
 }
 
-const set<int>& Graph::getEdges() const
+const vector<int>& Graph::getEdges() const
 {
-    return edges;
+    return store.getEdges();
+}
+
+const int Graph::getEdgeCapacity() const
+{
+    return store.getEdgeCapacity();
 }
 
 const int Graph::getEdgeCount() const
 {
-    return (int)edges.size();
+    return store.getEdgeCount();
+}
+
+const IdRange Graph::getInEdges(int node)
+{
+    return store.getInEdges(node);
+}
+
+const IdRange Graph::getOutEdges(int node)
+{
+    return store.getOutEdges(node);
 }
 
 const bool Graph::hasEdge(int source, int target)
 {
-    return nodeMap[source].adjacent.find(target) != nodeMap[source].adjacent.end();
+    return store.hasEdge(source, target);
 }
 
 const bool Graph::isBidirectional(int edge)
 {
-    return isBidirectional(edgeMap[edge].source, edgeMap[edge].target);
+    return isBidirectional(store.getEdge(edge).source, store.getEdge(edge).target);
 }
 
 const bool Graph::isBidirectional(int source, int target)
@@ -368,7 +808,7 @@ const bool Graph::isBidirectional(int source, int target)
 
 const bool Graph::isValidEdge(int edge) const
 {
-    return edgeMap.find(edge) != edgeMap.end();
+    return store.isValidEdge(edge);
 }
 
 void Graph::setEdgeColor(int edge, int r, int g, int b, int a)
@@ -378,41 +818,31 @@ void Graph::setEdgeColor(int edge, int r, int g, int b, int a)
 
 void Graph::setEdgeColor(int edge, double r, double g, double b, double a)
 {
-    GLMaterial::Color c(r, g, b, a);
-    int materialId = -1;
+    mutex.lock();
 
-    // look for color in the cache
-    for(int i = 0; i < (int)materialVector.size(); i++)
-    {
-        if(materialVector[i]->ambient == c)
-        {
-            materialId = i;
-            break;
-        }
-    }
+    int materialId = getMaterialId(GLMaterial::Color(r, g, b, a));
 
-    // if not found, add it
-    if(materialId == -1)
-    {
-        materialVector.push_back(new GLMaterial(c));
-        materialId = materialVector.size() - 1;
-    }
+    store.edge(edge).material = materialId;
 
-    edgeMap[edge].material = materialId;
+    mutex.unlock();
 
-    update();
+    redraw();
 }
 
 void Graph::setEdgeLabel(int edge, const std::string& label)
 {
-    edgeMap[edge].label = string(label);
+    mutex.lock();
+    store.edgeLabel(edge) = label;
+    mutex.unlock();
 
-    update();
+    redraw();
 }
 
 void Graph::setEdgeWeight(int edge, float weight)
 {
-    edgeMap[edge].weight = weight;
+    mutex.lock();
+    store.edge(edge).weight = weight;
+    mutex.unlock();
 
     update();
 }
@@ -424,23 +854,74 @@ const int Graph::addNode()
 {
     mutex.lock();
 
-    Node n;
+    int nodeId = store.addNode(getNewNodePosition());
+    addFloating(nodeId);
+    markChanged(nodeId);
+
+    mutex.unlock();
+    update();
+
+    return nodeId;
+}
 
+const Vrui::Point Graph::getNewNodePosition()
+{
     Vrui::Scalar scale = lastMaxDistance / 2; // effective radius
 
     // New point should be around previous center of graph
-    n.position = Vrui::Point(lastCenter[0] + scale * (2 * VruiHelp::randomFloat() - 1),
-                             lastCenter[1] + scale * (2 * VruiHelp::randomFloat() - 1),
-                             lastCenter[2] + scale * (2 * VruiHelp::randomFloat() - 1) );
+    return Vrui::Point(lastCenter[0] + scale * (2 * VruiHelp::randomFloat() - 1),
+                       lastCenter[1] + scale * (2 * VruiHelp::randomFloat() - 1),
+                       lastCenter[2] + scale * (2 * VruiHelp::randomFloat() - 1) );
+}
 
-    nodeId++;
-    nodes.insert(nodeId);
-    nodeMap[nodeId] = n;
+void Graph::addFloating(int node)
+{
+    if(floating)
+    {
+        floatingNodes[node] = make_pair(Vrui::Vector(0, 0, 0), 0);
+    }
+}
 
-    mutex.unlock();
-    update();
+void Graph::markChanged(int node)
+{
+    if(changedOverflow) return;
 
-    return nodeId;
+    if((int)changedNodes.size() < MAX_CHANGED_NODES)
+    {
+        changedNodes.push_back(node);
+    }
+    else
+    {
+        changedOverflow = true;
+        changedNodes.clear();
+    }
+}
+
+// Moves a floating node to the barycenter of the placed neighbors seen so
+// far, so the layout only has to settle it locally instead of pulling it in
+// from a random spot.
+void Graph::placeFloating(int node, int neighbor)
+{
+    map<int, pair<Vrui::Vector, int> >::iterator it = floatingNodes.find(node);
+
+    if(it == floatingNodes.end() || floatingNodes.count(neighbor))
+    {
+        return;
+    }
+
+    if(it->second.second == 0)
+    {
+        placedNodes.push_back(node);
+    }
+
+    it->second.first += store.getPosition(neighbor) - Vrui::Point::origin;
+    it->second.second++;
+
+    Vrui::Point center = Vrui::Point::origin + it->second.first / Vrui::Scalar(it->second.second);
+
+    store.position(node) = Vrui::Point(center[0] + PLACEMENT_OFFSET * (2 * VruiHelp::randomFloat() - 1),
+                                       center[1] + PLACEMENT_OFFSET * (2 * VruiHelp::randomFloat() - 1),
+                                       center[2] + PLACEMENT_OFFSET * (2 * VruiHelp::randomFloat() - 1) );
 }
 
 const int Graph::addNode(const Vrui::Point& position)
@@ -459,7 +940,9 @@ const int Graph::addNode(const string& s)
 
 const int Graph::deleteNode()
 {
-    return deleteNode(*nodes.begin());
+    if(store.getNodeCount() == 0) return -1;
+
+    return deleteNode(store.getNodes().front());
 }
 
 const int Graph::deleteNode(int node)
@@ -472,26 +955,19 @@ const int Graph::deleteNode(int node)
         return -1;
     }
 
-    vector<int> killList(0);
-
-    foreach(int edge, edges)
+    // the neighbors lose an edge
+    foreach(int edge, store.getOutEdges(node))
     {
-        Edge& e = edgeMap[edge];
-
-        if(e.source == node || e.target == node)
-        {
-            killList.push_back(edge);
-        }
+        markChanged(store.getEdge(edge).target);
     }
 
-    foreach(int edge, killList)
+    foreach(int edge, store.getInEdges(node))
     {
-        edges.erase(edge);
-        edgeMap.erase(edge);
+        markChanged(store.getEdge(edge).source);
     }
 
-    nodes.erase(node);
-    nodeMap.erase(node);
+    store.deleteNode(node);
+    floatingNodes.erase(node);
 
     mutex.unlock();
     update();
@@ -501,96 +977,105 @@ const int Graph::deleteNode(int node)
 
 const Attributes& Graph::getNodeAttributes(int node)
 {
-    return nodeMap[node].attributes;
+    return store.getAttributes(node);
 }
 
 const int Graph::getNodeComponent(int node)
 {
-    return nodeMap[node].component;
+    return store.getComponent(node);
 }
 
 const int Graph::getNodeDegree(int node)
 {
-    return nodeMap[node].inDegree + nodeMap[node].outDegree;
+    return store.getDegree(node);
 }
 
 const string& Graph::getNodeLabel(int node)
 {
-    return nodeMap[node].label;
+    return store.getLabel(node);
 }
 
 const GLMaterial* Graph::getNodeMaterial(int node)
 {
-    return getNodeMaterialFromId(nodeMap[node].material);
+    return getNodeMaterialFromId(store.getMaterial(node));
 }
 
-const set<int>& Graph::getNodes() const
+const vector<int>& Graph::getNodes() const
 {
-    return nodes;
+    return store.getNodes();
+}
+
+const int Graph::getNodeCapacity() const
+{
+    return store.getNodeCapacity();
 }
 
 const int Graph::getNodeCount() const
 {
-    return (int)nodes.size();
+    return store.getNodeCount();
 }
 
 const std::string& Graph::getNodeImagePath(int node)
 {
-    return nodeMap[node].imagePath;
+    return store.getImagePath(node);
 }
 
 const double Graph::getNodeImageScale(int node)
 {
-    return nodeMap[node].imageScale;
+    return store.getImageScale(node);
 }
 
 const Vrui::Point& Graph::getNodePosition(int node)
 {
-    return nodeMap[node].position;
+    return store.getPosition(node);
+}
+
+const vector<Vrui::Point>& Graph::getNodePositions() const
+{
+    return store.getPositions();
 }
 
 const float Graph::getNodeSize(int node)
 {
-    return nodeMap[node].size;
+    return store.getSize(node);
 }
 
 const std::string& Graph::getNodeType(int node)
 {
-    return nodeMap[node].type;
+    return store.getType(node);
 }
 
 const Vrui::Point& Graph::getSourceNodePosition(int edge)
 {
-    return nodeMap[edgeMap[edge].source].position;
+    return store.getPosition(store.getEdge(edge).source);
 }
 
 const Vrui::Point& Graph::getTargetNodePosition(int edge)
 {
-    return nodeMap[edgeMap[edge].target].position;
+    return store.getPosition(store.getEdge(edge).target);
 }
 
 const Vrui::Vector& Graph::getNodeVelocity(int node)
 {
-    return nodeMap[node].velocity;
+    return store.getVelocity(node);
 }
 
 const bool Graph::isValidNode(int node) const
 {
-    return nodeMap.find(node) != nodeMap.end();
+    return store.isValidNode(node);
 }
 
 void Graph::moveNodes(const Vrui::Vector &offset)
 {
-    // Note: we don't lock.  The drawing methods work with a copy.
-    // And so what if the layout algorithm works with the old position
-    // for one more time step, assuming the main or RPC thread modifies it.
-    // It will get the new one at the update. Hopefully this causes no issues.
-    foreach(int node, nodes)
+    mutex.lock();
+
+    foreach(int node, store.getNodes())
     {
-        nodeMap[node].position += offset;
+        store.position(node) += offset;
     }
     lastCenter += offset;
 
+    mutex.unlock();
     update();
 }
 
@@ -603,7 +1088,11 @@ void Graph::moveNodes(const Vrui::Point &offset)
 
 void Graph::setNodeAttribute(int node, string& key, string& value)
 {
-    nodeMap[node].attributes.push_back(pair<string, string>(key, value));
+    mutex.lock();
+    store.attributeList(node).push_back(pair<string, string>(key, value));
+    mutex.unlock();
+
+    redraw();
 }
 
 void Graph::setNodeColor(int node, int r, int g, int b, int a)
@@ -613,81 +1102,85 @@ void Graph::setNodeColor(int node, int r, int g, int b, int a)
 
 void Graph::setNodeColor(int node, double r, double g, double b, double a)
 {
-    GLMaterial::Color c(r, g, b, a);
-    int materialId = -1;
+    mutex.lock();
 
-    // look for color in the cache
-    for(int i = 0; i < (int)materialVector.size(); i++)
-    {
-        if(materialVector[i]->ambient == c)
-        {
-            materialId = i;
-            break;
-        }
-    }
+    int materialId = getMaterialId(GLMaterial::Color(r, g, b, a));
 
-    // if not found, add it
-    if(materialId == -1)
-    {
-        materialVector.push_back(new GLMaterial(c));
-        materialId = materialVector.size() - 1;
-    }
+    store.material(node) = materialId;
 
-    nodeMap[node].material = materialId;
+    mutex.unlock();
 
-    update();
+    redraw();
 }
 
 void Graph::setNodeImagePath(int node, const string& imagePath)
 {
-    nodeMap[node].imagePath = imagePath;
+    mutex.lock();
+    store.imagePath(node) = imagePath;
+    mutex.unlock();
 
-    update();
+    redraw();
 }
 
 void Graph::setNodeImageScale(int node, const double& scale)
 {
-    nodeMap[node].imageScale = scale;
+    mutex.lock();
+    store.imageScale(node) = scale;
+    mutex.unlock();
 
-    update();
+    redraw();
 }
 
 void Graph::setNodeLabel(int node, const std::string& label)
 {
-    nodeMap[node].label = label;
+    mutex.lock();
+    store.label(node) = label;
+    mutex.unlock();
 
-    update();
+    redraw();
 }
 
 void Graph::setNodePosition(int node, const Vrui::Point& position)
 {
-    nodeMap[node].position = position;
+    mutex.lock();
+    store.position(node) = position;
+    floatingNodes.erase(node);
+    markChanged(node);
+    mutex.unlock();
 
     update();
 }
 
 void Graph::setNodeType(int node, const string& type)
 {
-    nodeMap[node].type = type;
+    mutex.lock();
+    store.type(node) = type;
+    mutex.unlock();
 
-    update();
+    redraw();
 }
 
 void Graph::setNodeVelocity(int node, const Vrui::Vector& velocity)
 {
-    nodeMap[node].velocity = velocity;
+    mutex.lock();
+    store.velocity(node) = velocity;
+    mutex.unlock();
 }
 
 void Graph::setNodeSize(int node, float size)
 {
-    nodeMap[node].size = size;
+    mutex.lock();
+    store.size(node) = size;
+    mutex.unlock();
 
-    update();
+    redraw();
 }
 
 void Graph::updateNodePosition(int node, const Vrui::Vector& delta)
 {
-    nodeMap[node].position += delta;
+    mutex.lock();
+    store.position(node) += delta;
+    mutex.unlock();
 
     update();
 }
@@ -695,7 +1188,9 @@ void Graph::updateNodePosition(int node, const Vrui::Vector& delta)
 // no update() needed
 void Graph::updateNodeVelocity(int node, const Vrui::Vector& delta)
 {
-    nodeMap[node].velocity += delta;
+    mutex.lock();
+    store.velocity(node) += delta;
+    mutex.unlock();
 }
 
 /*
@@ -705,14 +1200,15 @@ boost::BoostGraph Graph::toBoost()
 {
     boost::BoostGraph g;
 
-    for(int node = 0; node > getNodeCount(); node++)
+    // vertices are indexed by node id, deleted ids stay as isolated vertices
+    for(int node = 0; node < store.getNodeCapacity(); node++)
     {
         boost::add_vertex(g);
     }
 
-    for(int edge = 0; edge < getEdgeCount(); edge++)
+    foreach(int edge, store.getEdges())
     {
-        boost::add_edge(edgeMap[edge].source, edgeMap[edge].target, g);
+        boost::add_edge(store.getEdge(edge).source, store.getEdge(edge).target, g);
     }
 
     return g;
@@ -725,7 +1221,7 @@ vector<double> Graph::getBetweennessCentrality()
     mutex.lock();
 
     boost::BoostGraph g = toBoost();
-    vector<double> bc(getNodeCount());
+    vector<double> bc(store.getNodeCapacity());
 
     if(getNodeCount() == 0) return bc;
     brandes_betweenness_centrality(g,
@@ -740,8 +1236,8 @@ vector<int> Graph::getShortestPath()
     mutex.lock();
 
     boost::BoostGraph g = toBoost();
-    vector<int> p(getNodeCount());
-    vector<int> d(getNodeCount());
+    vector<int> p(store.getNodeCapacity());
+    vector<int> d(store.getNodeCapacity());
 
     if(getNodeCount() == 0) return p;
     dijkstra_shortest_paths(g,
@@ -765,7 +1261,7 @@ vector<int> Graph::getSpanningTree()
     mutex.lock();
 
     boost::BoostGraph g = toBoost();
-    vector<int> p(getNodeCount());
+    vector<int> p(store.getNodeCapacity());
 
     if(getNodeCount() == 0) return p;
     prim_minimum_spanning_tree(g, &p[0]);
@@ -779,13 +1275,13 @@ void Graph::setComponents()
     mutex.lock();
 
     boost::BoostGraph g = toBoost();
-    vector<int> c(getNodeCount());
+    vector<int> c(store.getNodeCapacity());
 
-    connected_components(g, &c[0]);
+    if(c.size() > 0) connected_components(g, &c[0]);
 
-    foreach(int node, nodes)
+    foreach(int node, store.getNodes())
     {
-        nodeMap[node].component = c[node];
+        store.component(node) = c[node];
     }
 
     mutex.unlock();
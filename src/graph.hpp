@@ -19,14 +19,14 @@
 #ifndef __GRAPH_HPP
 #define __GRAPH_HPP
 
+#include <graphstore.hpp>
 #include <mycelia.hpp>
+#include <positionbuffer.hpp>
 #include <vruihelp.hpp>
 
-#define MATERIAL_NODE_DEFAULT 0
-#define MATERIAL_EDGE_DEFAULT 1
-#define MATERIAL_SELECTED 2
-#define MATERIAL_SELECTED_PREVIOUS 3
-#define MATERIAL_HIGHLIGHTED 4
+#define MAX_CHANGED_NODES 4096 // more changes than this relax the whole graph
+#define PLACEMENT_OFFSET 0.5 // spread of new nodes around their neighbors' barycenter
+#define TRANSACTION_TIMEOUT 30 // seconds before an open transaction is committed anyway
 
 namespace boost
 {
@@ -35,82 +35,12 @@ typedef adjacency_list < vecS, vecS, undirectedS,
         property<edge_weight_t, double> > BoostGraph;
 }
 
-typedef std::vector<std::pair<std::string, std::string> > Attributes;
-
-class Node
-{
-public:
-    Vrui::Point position;
-    Vrui::Vector velocity;
-    std::tr1::unordered_map<int, std::list<int> > adjacent;
-
-
-    std::string label;
-    std::string type;
-
-    // These are used if the type is "image".
-    std::string imagePath;
-    double imageScale;
-
-    Attributes attributes;
-    float size;
-    int component;
-    int inDegree;
-    int outDegree;
-    int material;
-
-    Node()
-    {
-        position = Vrui::Point(0, 0, 0);
-        velocity = Vrui::Vector(0, 0, 0);
-        type = "shape";
-        size = 1;
-        component = 0;
-        inDegree = 0;
-        outDegree = 0;
-        material = MATERIAL_NODE_DEFAULT;
-        imageScale = 1;
-    }
-};
-
-class Edge
-{
-public:
-    int source;
-    int target;
-    std::string label;
-    int material;
-    float weight;
-
-    Edge()
-       : source(0),
-         target(0),
-         material(MATERIAL_EDGE_DEFAULT),
-         weight(1)
-    {
-    }
-
-    Edge(int s, int t)
-      : source(s),
-        target(t),
-        material(MATERIAL_EDGE_DEFAULT),
-        weight(1)
-    {
-    }
-};
-
 class Graph
 {
 private:
     Mycelia* application;
 
-    std::tr1::unordered_map<int, Node> nodeMap;
-    std::set<int> nodes;
-    int nodeId;
-
-    std::tr1::unordered_map<int, Edge> edgeMap;
-    std::set<int> edges;
-    int edgeId;
+    GraphStore store;
 
     /** This needs to be moved to dataItem, or Graph should derive from GLObject */
     std::vector<GLMaterial*> materialVector;
@@ -123,7 +53,33 @@ private:
     int version;
     Threads::Mutex mutex;
 
-    const std::list<int> empty; // returned by getEdges when none exist
+    // state seen by snapshots while a transaction is open
+    int transactionDepth;
+    bool transactionModified;
+    bool transactionWake; // some change held back needs the layout
+    time_t transactionStart;
+    GraphStore committedStore;
+    std::string committedTextureNodeMode;
+
+    // Nodes added without a position while the dynamic layout runs float
+    // until their edges arrive, and sit at the barycenter of their neighbors
+    // meanwhile (summed offset and count). Once placed, they are handed to
+    // the layout with the next changed list. Changed nodes are collected
+    // for incremental layout.
+    bool floating; // the dynamic layout is selected, set by setDynamicLayout
+    std::map<int, std::pair<Vrui::Vector, int> > floatingNodes;
+    std::vector<int> placedNodes;
+    std::vector<int> changedNodes;
+    bool changedOverflow; // too many to list, treat all as changed
+
+    // callers hold the mutex
+    const int getMaterialId(const GLMaterial::Color&);
+    const Vrui::Point getNewNodePosition();
+    void addFloating(int);
+    void bumpVersion(bool);
+    void markChanged(int);
+    void placeFloating(int, int);
+    void publishLayout();
 
 public:
     Graph(Mycelia*);
@@ -140,23 +96,50 @@ public:
     const int getVersion() const;
     void randomizePositions(Vrui::Scalar);
 
+    void redraw();
     void setTextureNodeMode(std::string&);
     void update();
     void write(const char*);
     void lock() { mutex.lock(); }
     void unlock() { mutex.unlock(); }
 
+    // transactions, snapshots see all or none of the changes in between
+    void begin();
+    void commit();
+    const bool expireTransaction();
+
+    // layout, deltas are indexed by node id
+    const bool readLayout(const PositionBuffer&);
+    const bool takeChangedNodes(std::vector<int>&);
+    void setDynamicLayout(bool);
+    void setLayoutPositions(const std::vector<int>&, const std::vector<Vrui::Point>&);
+    void updateLayout(const std::vector<Vrui::Vector>&, const std::vector<Vrui::Vector>&);
+
+    // batch, one lock and one update() per call
+    void reserve(int, int);
+    const std::vector<int> addNodes(int);
+    const std::vector<int> addEdges(const std::vector<std::pair<int, int> >&);
+    void setEdgeLabels(const std::vector<int>&, const std::vector<std::string>&);
+    void setNodeAttributes(const std::vector<int>&, const std::vector<Attributes>&);
+    void setNodeColors(const std::vector<int>&, const std::vector<GLMaterial::Color>&);
+    void setNodeLabels(const std::vector<int>&, const std::vector<std::string>&);
+    void setNodePositions(const std::vector<int>&, const std::vector<Vrui::Point>&);
+    void setNodeSizes(const std::vector<int>&, const std::vector<float>&);
+
     // edges
     const int addEdge(int, int);
     void clearEdges();
     const int deleteEdge(int);
     const Edge& getEdge(int);
-    const std::set<int>& getEdges() const;
-    const std::list<int>& getEdges(int, int);
+    const std::vector<int>& getEdges() const;
+    const IdRange getEdges(int, int);
+    const int getEdgeCapacity() const; // one past the largest edge id
     const int getEdgeCount() const;
     const GLMaterial* getEdgeMaterial(int);
     const std::string& getEdgeLabel(int);
     const float getEdgeWeight(int);
+    const IdRange getInEdges(int);
+    const IdRange getOutEdges(int);
     const bool hasEdge(int, int);
     const bool isBidirectional(int);
     const bool isBidirectional(int, int);
@@ -176,12 +159,14 @@ public:
     const int getNodeComponent(int);
     const int getNodeDegree(int);
     const std::string& getNodeLabel(int);
-    const std::set<int>& getNodes() const;
+    const std::vector<int>& getNodes() const;
+    const int getNodeCapacity() const; // one past the largest node id
     const int getNodeCount() const;
     const std::string& getNodeImagePath(int);
     const double getNodeImageScale(int);
     const GLMaterial* getNodeMaterial(int);
     const Vrui::Point& getNodePosition(int);
+    const std::vector<Vrui::Point>& getNodePositions() const;
     const Vrui::Vector& getNodeVelocity(int);
     const float getNodeSize(int);
     const std::string& getNodeType(int);
@@ -0,0 +1,368 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <graphstore.hpp>
+
+using namespace std;
+
+GraphStore::GraphStore()
+{
+    clear();
+}
+
+void GraphStore::clear()
+{
+    resizeNodes(0);
+    freeNodes.edit().clear();
+    nodeCount = 0;
+
+    resizeEdges(0);
+    freeEdges.edit().clear();
+    edgeCount = 0;
+
+    dirty = true;
+}
+
+void GraphStore::clearEdges()
+{
+    resizeEdges(0);
+    freeEdges.edit().clear();
+    edgeCount = 0;
+
+    inDegrees.edit().assign(inDegrees.size(), 0);
+    outDegrees.edit().assign(outDegrees.size(), 0);
+
+    dirty = true;
+}
+
+void GraphStore::reserve(int nodeCapacity, int edgeCapacity)
+{
+    positions.edit().reserve(nodeCapacity);
+    velocities.edit().reserve(nodeCapacity);
+    sizes.edit().reserve(nodeCapacity);
+    materials.edit().reserve(nodeCapacity);
+    components.edit().reserve(nodeCapacity);
+    inDegrees.edit().reserve(nodeCapacity);
+    outDegrees.edit().reserve(nodeCapacity);
+    nodeAlive.edit().reserve(nodeCapacity);
+
+    labels.edit().reserve(nodeCapacity);
+    types.edit().reserve(nodeCapacity);
+    imagePaths.edit().reserve(nodeCapacity);
+    imageScales.edit().reserve(nodeCapacity);
+    attributes.edit().reserve(nodeCapacity);
+
+    edges.edit().reserve(edgeCapacity);
+    edgeLabels.edit().reserve(edgeCapacity);
+    edgeAlive.edit().reserve(edgeCapacity);
+}
+
+void GraphStore::resizeNodes(int capacity)
+{
+    positions.edit().resize(capacity, Vrui::Point(0, 0, 0));
+    velocities.edit().resize(capacity, Vrui::Vector(0, 0, 0));
+    sizes.edit().resize(capacity, 1);
+    materials.edit().resize(capacity, MATERIAL_NODE_DEFAULT);
+    components.edit().resize(capacity, 0);
+    inDegrees.edit().resize(capacity, 0);
+    outDegrees.edit().resize(capacity, 0);
+    nodeAlive.edit().resize(capacity, 0);
+
+    labels.edit().resize(capacity);
+    types.edit().resize(capacity, "shape");
+    imagePaths.edit().resize(capacity);
+    imageScales.edit().resize(capacity, 1);
+    attributes.edit().resize(capacity);
+}
+
+void GraphStore::resizeEdges(int capacity)
+{
+    edges.edit().resize(capacity);
+    edgeLabels.edit().resize(capacity);
+    edgeAlive.edit().resize(capacity, 0);
+}
+
+/*
+ * topology
+ */
+const int GraphStore::addNode(const Vrui::Point& position)
+{
+    int node;
+
+    if(freeNodes.empty())
+    {
+        node = getNodeCapacity();
+        resizeNodes(node + 1);
+    }
+    else
+    {
+        node = freeNodes.read().back();
+        freeNodes.edit().pop_back();
+    }
+
+    positions.edit()[node] = position;
+    velocities.edit()[node] = Vrui::Vector(0, 0, 0);
+    sizes.edit()[node] = 1;
+    materials.edit()[node] = MATERIAL_NODE_DEFAULT;
+    components.edit()[node] = 0;
+    inDegrees.edit()[node] = 0;
+    outDegrees.edit()[node] = 0;
+    nodeAlive.edit()[node] = 1;
+
+    labels.edit()[node].clear();
+    types.edit()[node] = "shape";
+    imagePaths.edit()[node].clear();
+    imageScales.edit()[node] = 1;
+    attributes.edit()[node].clear();
+
+    nodeCount++;
+    dirty = true;
+
+    return node;
+}
+
+const int GraphStore::addEdge(int source, int target)
+{
+    if(!isValidNode(source) || !isValidNode(target))
+    {
+        return -1;
+    }
+
+    int e;
+
+    if(freeEdges.empty())
+    {
+        e = getEdgeCapacity();
+        resizeEdges(e + 1);
+    }
+    else
+    {
+        e = freeEdges.read().back();
+        freeEdges.edit().pop_back();
+    }
+
+    edges.edit()[e] = Edge(source, target);
+    edgeLabels.edit()[e].clear();
+    edgeAlive.edit()[e] = 1;
+
+    outDegrees.edit()[source]++;
+    inDegrees.edit()[target]++;
+
+    edgeCount++;
+    dirty = true;
+
+    return e;
+}
+
+void GraphStore::deleteEdge(int e)
+{
+    if(!isValidEdge(e))
+    {
+        return;
+    }
+
+    outDegrees.edit()[edges[e].source]--;
+    inDegrees.edit()[edges[e].target]--;
+
+    edgeAlive.edit()[e] = 0;
+    edgeLabels.edit()[e].clear();
+    freeEdges.edit().push_back(e);
+
+    edgeCount--;
+    dirty = true;
+}
+
+void GraphStore::deleteNode(int node)
+{
+    if(!isValidNode(node))
+    {
+        return;
+    }
+
+    // copy first, deleting marks the adjacency dirty
+    IdRange out = getOutEdges(node);
+    IdRange in = getInEdges(node);
+    vector<int> killList(out.first, out.second);
+    killList.insert(killList.end(), in.first, in.second);
+
+    foreach(int e, killList)
+    {
+        deleteEdge(e);
+    }
+
+    nodeAlive.edit()[node] = 0;
+    labels.edit()[node].clear();
+    imagePaths.edit()[node].clear();
+    attributes.edit()[node].clear();
+    freeNodes.edit().push_back(node);
+
+    nodeCount--;
+    dirty = true;
+}
+
+const vector<int>& GraphStore::getNodes() const
+{
+    ensureCompact();
+    return views->nodeList;
+}
+
+const vector<int>& GraphStore::getEdges() const
+{
+    ensureCompact();
+    return views->edgeList;
+}
+
+const IdRange GraphStore::getEdges(int source, int target) const
+{
+    ensureCompact();
+    const Views& v = *views;
+
+    if(!isValidNode(source))
+    {
+        return IdRange(v.outEdges.end(), v.outEdges.end());
+    }
+
+    // targets are sorted within each source's run
+    vector<int>::const_iterator begin = v.outTargets.begin() + v.outOffsets[source];
+    vector<int>::const_iterator end = v.outTargets.begin() + v.outOffsets[source + 1];
+    pair<vector<int>::const_iterator, vector<int>::const_iterator> r = equal_range(begin, end, target);
+
+    return IdRange(v.outEdges.begin() + (r.first - v.outTargets.begin()),
+                   v.outEdges.begin() + (r.second - v.outTargets.begin()));
+}
+
+const IdRange GraphStore::getInEdges(int node) const
+{
+    ensureCompact();
+    const Views& v = *views;
+
+    if(!isValidNode(node))
+    {
+        return IdRange(v.inEdges.end(), v.inEdges.end());
+    }
+
+    return IdRange(v.inEdges.begin() + v.inOffsets[node], v.inEdges.begin() + v.inOffsets[node + 1]);
+}
+
+const IdRange GraphStore::getOutEdges(int node) const
+{
+    ensureCompact();
+    const Views& v = *views;
+
+    if(!isValidNode(node))
+    {
+        return IdRange(v.outEdges.end(), v.outEdges.end());
+    }
+
+    return IdRange(v.outEdges.begin() + v.outOffsets[node], v.outEdges.begin() + v.outOffsets[node + 1]);
+}
+
+const bool GraphStore::hasEdge(int source, int target) const
+{
+    IdRange r = getEdges(source, target);
+    return r.first != r.second;
+}
+
+/*
+ * compaction
+ */
+// Readers on other threads may get here at once, the first compacts. The
+// acquire pairs with the release below, so a reader that sees clean views
+// also sees what compact() wrote.
+void GraphStore::ensureCompact() const
+{
+    if(!__atomic_load_n(&dirty, __ATOMIC_ACQUIRE)) return;
+
+    compactMutex.mutex.lock();
+
+    if(dirty)
+    {
+        compact();
+        __atomic_store_n(&dirty, false, __ATOMIC_RELEASE);
+    }
+
+    compactMutex.mutex.unlock();
+}
+
+// Stable counting sort of edge ids by one endpoint. offsets receives the
+// start of each node's run and has one entry more than there are nodes.
+static void bucketEdges(const vector<int>& in, const vector<Edge>& edges, bool bySource,
+                        int capacity, vector<int>& offsets, vector<int>& out)
+{
+    offsets.assign(capacity + 1, 0);
+    out.resize(in.size());
+
+    foreach(int e, in)
+    {
+        offsets[(bySource ? edges[e].source : edges[e].target) + 1]++;
+    }
+
+    for(int node = 0; node < capacity; node++)
+    {
+        offsets[node + 1] += offsets[node];
+    }
+
+    vector<int> cursor(offsets.begin(), offsets.end() - 1);
+
+    foreach(int e, in)
+    {
+        out[cursor[bySource ? edges[e].source : edges[e].target]++] = e;
+    }
+}
+
+void GraphStore::compact() const
+{
+    int capacity = getNodeCapacity();
+    const vector<Edge>& edgeData = edges.read();
+
+    // build into a fresh object, copies may still hold the old one
+    Views* v = new Views();
+
+    v->nodeList.reserve(nodeCount);
+
+    for(int node = 0; node < capacity; node++)
+    {
+        if(nodeAlive[node]) v->nodeList.push_back(node);
+    }
+
+    v->edgeList.reserve(edgeCount);
+
+    for(int e = 0; e < getEdgeCapacity(); e++)
+    {
+        if(edgeAlive[e]) v->edgeList.push_back(e);
+    }
+
+    // sorting by the far endpoint first leaves each run ordered by neighbor
+    vector<int> offsets;
+    vector<int> sorted;
+
+    bucketEdges(v->edgeList, edgeData, false, capacity, offsets, sorted);
+    bucketEdges(sorted, edgeData, true, capacity, v->outOffsets, v->outEdges);
+
+    bucketEdges(v->edgeList, edgeData, true, capacity, offsets, sorted);
+    bucketEdges(sorted, edgeData, false, capacity, v->inOffsets, v->inEdges);
+
+    v->outTargets.resize(v->outEdges.size());
+
+    for(int i = 0; i < (int)v->outEdges.size(); i++)
+    {
+        v->outTargets[i] = edgeData[v->outEdges[i]].target;
+    }
+
+    views.reset(v);
+}
@@ -0,0 +1,235 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GRAPHSTORE_HPP
+#define __GRAPHSTORE_HPP
+
+#include <mycelia.hpp>
+
+#define MATERIAL_NODE_DEFAULT 0
+#define MATERIAL_EDGE_DEFAULT 1
+#define MATERIAL_SELECTED 2
+#define MATERIAL_SELECTED_PREVIOUS 3
+#define MATERIAL_HIGHLIGHTED 4
+
+typedef std::vector<std::pair<std::string, std::string> > Attributes;
+
+// a contiguous run of node or edge ids, usable with foreach
+typedef std::pair<std::vector<int>::const_iterator, std::vector<int>::const_iterator> IdRange;
+
+class Edge
+{
+public:
+    int source;
+    int target;
+    int material;
+    float weight;
+
+    Edge()
+       : source(0),
+         target(0),
+         material(MATERIAL_EDGE_DEFAULT),
+         weight(1)
+    {
+    }
+
+    Edge(int s, int t)
+      : source(s),
+        target(t),
+        material(MATERIAL_EDGE_DEFAULT),
+        weight(1)
+    {
+    }
+};
+
+/*
+ * Reference counted array that is shared between copies until one of them
+ * writes. Copying is O(1); the first edit() after a copy clones the array.
+ */
+template <class T>
+class CowVector
+{
+private:
+    boost::shared_ptr<std::vector<T> > data;
+
+public:
+    CowVector()
+      : data(new std::vector<T>())
+    {
+    }
+
+    const std::vector<T>& read() const { return *data; }
+    const T& operator[](int i) const { return (*data)[i]; }
+    const int size() const { return (int)data->size(); }
+    const bool empty() const { return data->empty(); }
+
+    std::vector<T>& edit()
+    {
+        if(!data.unique())
+        {
+            data.reset(new std::vector<T>(*data));
+        }
+
+        return *data;
+    }
+};
+
+/*
+ * Dense storage behind Graph. Node and edge ids index directly into
+ * parallel arrays; deleted ids go on a free list and are handed out again
+ * by the next add. Adjacency is kept in CSR form (offsets + edge ids sorted
+ * by neighbor), rebuilt lazily the first time it is read after a topology
+ * change. No locking is done here; Graph serializes writers.
+ *
+ * Every array is a CowVector, so copying a store is a handful of reference
+ * count increments and a writer only clones the arrays it touches. A copy
+ * taken by the render thread stays immutable while layouts keep writing.
+ */
+class GraphStore
+{
+private:
+    // copies of the store get their own mutex
+    struct CompactMutex
+    {
+        Threads::Mutex mutex;
+
+        CompactMutex() {}
+        CompactMutex(const CompactMutex&) {}
+        CompactMutex& operator=(const CompactMutex&) { return *this; }
+    };
+
+    // hot node data, indexed by node id
+    CowVector<Vrui::Point> positions;
+    CowVector<Vrui::Vector> velocities;
+    CowVector<float> sizes;
+    CowVector<int> materials;
+    CowVector<int> components;
+    CowVector<int> inDegrees;
+    CowVector<int> outDegrees;
+    CowVector<char> nodeAlive;
+
+    // cold node data, indexed by node id
+    CowVector<std::string> labels;
+    CowVector<std::string> types;
+    CowVector<std::string> imagePaths;
+    CowVector<double> imageScales;
+    CowVector<Attributes> attributes;
+
+    CowVector<int> freeNodes;
+    int nodeCount;
+
+    // edge data, indexed by edge id
+    CowVector<Edge> edges;
+    CowVector<std::string> edgeLabels;
+    CowVector<char> edgeAlive;
+
+    CowVector<int> freeEdges;
+    int edgeCount;
+
+    // derived views, rebuilt as a whole and shared between copies
+    struct Views
+    {
+        std::vector<int> nodeList;
+        std::vector<int> edgeList;
+        std::vector<int> outOffsets;
+        std::vector<int> outEdges;
+        std::vector<int> outTargets;
+        std::vector<int> inOffsets;
+        std::vector<int> inEdges;
+    };
+
+    mutable boost::shared_ptr<const Views> views; // valid while !dirty
+    mutable bool dirty; // cleared by ensureCompact with release ordering
+    mutable CompactMutex compactMutex;
+
+    void compact() const;
+    void ensureCompact() const;
+    void resizeNodes(int);
+    void resizeEdges(int);
+
+public:
+    GraphStore();
+
+    void clear();
+    void clearEdges();
+    void reserve(int, int);
+
+    // topology
+    const int addNode(const Vrui::Point&);
+    const int addEdge(int, int);
+    void deleteNode(int);
+    void deleteEdge(int);
+
+    const int getNodeCapacity() const { return nodeAlive.size(); }
+    const int getEdgeCapacity() const { return edgeAlive.size(); }
+    const int getNodeCount() const { return nodeCount; }
+    const int getEdgeCount() const { return edgeCount; }
+    const std::vector<int>& getNodes() const;
+    const std::vector<int>& getEdges() const;
+    const IdRange getEdges(int, int) const;
+    const IdRange getInEdges(int) const;
+    const IdRange getOutEdges(int) const;
+    const bool hasEdge(int, int) const;
+
+    const bool isValidNode(int node) const
+    {
+        return node >= 0 && node < nodeAlive.size() && nodeAlive[node];
+    }
+
+    const bool isValidEdge(int edge) const
+    {
+        return edge >= 0 && edge < edgeAlive.size() && edgeAlive[edge];
+    }
+
+    // node data, writing clones the array if it is shared
+    Vrui::Point& position(int node) { return positions.edit()[node]; }
+    Vrui::Vector& velocity(int node) { return velocities.edit()[node]; }
+    float& size(int node) { return sizes.edit()[node]; }
+    int& material(int node) { return materials.edit()[node]; }
+    int& component(int node) { return components.edit()[node]; }
+    std::string& label(int node) { return labels.edit()[node]; }
+    std::string& type(int node) { return types.edit()[node]; }
+    std::string& imagePath(int node) { return imagePaths.edit()[node]; }
+    double& imageScale(int node) { return imageScales.edit()[node]; }
+    Attributes& attributeList(int node) { return attributes.edit()[node]; }
+
+    std::vector<Vrui::Point>& editPositions() { return positions.edit(); }
+    std::vector<Vrui::Vector>& editVelocities() { return velocities.edit(); }
+
+    const std::vector<Vrui::Point>& getPositions() const { return positions.read(); }
+    const Vrui::Point& getPosition(int node) const { return positions[node]; }
+    const Vrui::Vector& getVelocity(int node) const { return velocities[node]; }
+    const float getSize(int node) const { return sizes[node]; }
+    const int getMaterial(int node) const { return materials[node]; }
+    const int getComponent(int node) const { return components[node]; }
+    const int getDegree(int node) const { return inDegrees[node] + outDegrees[node]; }
+    const std::string& getLabel(int node) const { return labels[node]; }
+    const std::string& getType(int node) const { return types[node]; }
+    const std::string& getImagePath(int node) const { return imagePaths[node]; }
+    const double getImageScale(int node) const { return imageScales[node]; }
+    const Attributes& getAttributes(int node) const { return attributes[node]; }
+
+    // edge data
+    Edge& edge(int edge) { return edges.edit()[edge]; }
+    std::string& edgeLabel(int edge) { return edgeLabels.edit()[edge]; }
+
+    const Edge& getEdge(int edge) const { return edges[edge]; }
+    const std::string& getEdgeLabel(int edge) const { return edgeLabels[edge]; }
+};
+
+#endif
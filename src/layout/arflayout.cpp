@@ -23,7 +23,18 @@
 using namespace std;
 
 ArfLayout::ArfLayout(Mycelia* application)
-    : GraphLayout(application)
+    : GraphLayout(application),
+      woken(false),
+      globalWake(false),
+      settled(false),
+      moved(false),
+      stillSteps(0),
+      runSteps(0),
+      stepLimit(0),
+      resting(false),
+      incremental(false),
+      regionDirty(false),
+      incrementalSteps(0)
 {
     dynamic = true;
     
@@ -31,6 +42,7 @@ ArfLayout::ArfLayout(Mycelia* application)
     beta = -0.45;
     deltaTime = 0.01;
     layoutRadius = 2;
+    theta = 0.8;
     
     connectedSpringConstant = -2;
     stronglyConnectedSpringConstant = -2;
@@ -39,6 +51,71 @@ ArfLayout::ArfLayout(Mycelia* application)
     connectedSpringLength = 1;
     stronglyConnectedSpringLength = 1;
     unconnectedSpringLength = 1;
+    
+    snapshot = new Graph(application);
+}
+
+ArfLayout::~ArfLayout()
+{
+    stop();
+    delete snapshot;
+}
+
+// Unconnected spring plus repulsion on one node, which every other node
+// exerts. Far cells act as their point count placed at their center of
+// mass. Connected pairs are corrected afterwards, edge by edge.
+class ArfInteraction
+{
+private:
+    Vrui::Point position;
+    double springConstant;
+    double springLength;
+    double repulsionConstant;
+    double beta;
+    
+    inline Vrui::Vector force(const Vrui::Vector& v) const
+    {
+        Vrui::Scalar mag = Geometry::mag(v);
+        
+        if(mag == 0) return Vrui::Vector(0, 0, 0);
+        
+        double constA = springConstant * (mag - springLength) / mag;
+        double constB = repulsionConstant / pow(mag, 1 + beta);
+        return (constA + constB) * v;
+    }
+    
+public:
+    Vrui::Vector total;
+    
+    ArfInteraction(const vector<Vrui::Point>& positions, int node, double springConstant, double springLength,
+                   double repulsionConstant, double beta)
+        : position(positions[node]),
+          springConstant(springConstant),
+          springLength(springLength),
+          repulsionConstant(repulsionConstant),
+          beta(beta),
+          total(0, 0, 0)
+    {
+    }
+    
+    void points(const PackedPoints& packed, int begin, int end)
+    {
+        total += ForceKernel::interaction(packed, begin, end, position, springConstant, springLength,
+                                          repulsionConstant, beta);
+    }
+    
+    void cell(const Octree::Cell& c)
+    {
+        total += force(position - c.center) * c.mass;
+    }
+};
+
+void ArfLayout::getParameters(vector<double>& parameters) const
+{
+    double values[] = { dampingConstant, beta, deltaTime, layoutRadius, theta,
+                        connectedSpringConstant, stronglyConnectedSpringConstant, unconnectedSpringConstant,
+                        connectedSpringLength, stronglyConnectedSpringLength, unconnectedSpringLength };
+    parameters.insert(parameters.end(), values, values + sizeof(values) / sizeof(double));
 }
 
 inline double ArfLayout::getSpringConstant(int edgeCount) const
@@ -77,70 +154,400 @@ inline double ArfLayout::getSpringLength(int edgeCount) const
     }
 }
 
-// If removing nodes/edges is enabled (ex: rpcserver), layoutStep needs to be
-// locked.
+// layoutStep works on a snapshot, so the graph may change between steps
 void* ArfLayout::layout()
 {
+    stillSteps = 0;
+    runSteps = 0;
+    moved = true; // a fresh start always reports when it settles
+    vector<int> changed;
+    
     while(!stopped)
     {
-        //application->g->lock();
-        layoutStep();
-        //application->g->unlock();
+        wakeMutex.lock();
+        bool global = globalWake;
+        woken = false;
+        globalWake = false;
+        wakeMutex.unlock();
+        
+        bool local = application->g->takeChangedNodes(changed);
+        updateRegion(global, local, changed);
+        
+        if(layoutStep() < SETTLED_ENERGY)
+        {
+            stillSteps++;
+        }
+        else
+        {
+            stillSteps = 0;
+            moved = true;
+        }
+        
+        if(incremental)
+        {
+            incrementalSteps++;
+        }
+        
+        runSteps++;
+        
+        // nothing is moving, or the step limit is spent, wait for a reason
+        // to start again
+        if(stillSteps >= SETTLED_STEPS
+           || (incremental && (region.empty() || incrementalSteps >= INCREMENTAL_STEPS))
+           || (stepLimit > 0 && runSteps >= stepLimit))
+        {
+            sleep();
+            stillSteps = 0;
+            runSteps = 0;
+            resting = true;
+            incremental = false;
+            seeds.clear();
+            region.clear();
+        }
     }
     
     return 0;
 }
 
-void ArfLayout::layoutStep()
+// Picks full or local relaxation for the next step. A rested layout woken by
+// a short list of edits relaxes locally, anything else (parameter changes,
+// a reset, too many edits) runs over every node. Edits made during a local
+// relaxation join it and renew its step budget.
+void ArfLayout::updateRegion(bool global, bool local, const vector<int>& changed)
 {
-    int nodeCount = application->g->getNodeCount();
-    vector<Vrui::Vector> velocityVector(nodeCount);
-    vector<Vrui::Vector> positionVector(nodeCount);
+    if(global || !local)
+    {
+        incremental = false;
+    }
+    else if(resting)
+    {
+        incremental = true;
+        incrementalSteps = 0;
+        seeds.clear();
+        regionDirty = true;
+    }
+    
+    resting = false;
+    
+    if(!incremental || changed.empty())
+    {
+        return;
+    }
+    
+    seeds.insert(seeds.end(), changed.begin(), changed.end());
+    sort(seeds.begin(), seeds.end());
+    seeds.erase(unique(seeds.begin(), seeds.end()), seeds.end());
+    
+    incrementalSteps = 0;
+    regionDirty = true;
     
-    foreach(int source, application->g->getNodes())
+    if((int)seeds.size() > MAX_CHANGED_NODES)
     {
-        if(!application->isSelectedComponent(source) || source == application->getSelectedNode())
+        incremental = false;
+    }
+}
+
+// Breadth first search from the seeds, limited to the selected component.
+void ArfLayout::buildRegion(Graph* graph, const vector<char>& selected)
+{
+    vector<char> visited(selected.size());
+    vector<int> frontier;
+    region.clear();
+    
+    foreach(int node, seeds)
+    {
+        if(graph->isValidNode(node) && selected[node])
         {
-            continue;
+            visited[node] = 1;
+            frontier.push_back(node);
         }
+    }
+    
+    for(int hop = 0; hop <= INCREMENTAL_HOPS && !frontier.empty(); hop++)
+    {
+        region.insert(region.end(), frontier.begin(), frontier.end());
         
-        double mass = application->g->getNodeSize(source); // treat size as mass
-        Vrui::Vector velocity = application->g->getNodeVelocity(source);
-        Vrui::Vector dampingForce = dampingConstant * velocity;
+        if(hop == INCREMENTAL_HOPS)
+        {
+            break;
+        }
         
-        foreach(int target, application->g->getNodes())
+        vector<int> next;
+        
+        foreach(int node, frontier)
         {
-            if(stopped)
+            foreach(int edge, graph->getOutEdges(node))
             {
-                return;
+                int target = graph->getEdge(edge).target;
+                
+                if(selected[target] && !visited[target])
+                {
+                    visited[target] = 1;
+                    next.push_back(target);
+                }
             }
             
-            if(!application->isSelectedComponent(target) || source == target)
+            foreach(int edge, graph->getInEdges(node))
+            {
+                int source = graph->getEdge(edge).source;
+                
+                if(selected[source] && !visited[source])
+                {
+                    visited[source] = 1;
+                    next.push_back(source);
+                }
+            }
+        }
+        
+        frontier.swap(next);
+    }
+    
+    sort(region.begin(), region.end());
+    regionDirty = false;
+}
+
+// Blocks until wake() or stop(). Returns at once if either came after the
+// current step began, since the step may not have seen the change. A wake
+// that moved nothing goes back to sleep without reporting settled again.
+void ArfLayout::sleep()
+{
+    wakeMutex.lock();
+    
+    if(!woken && !stopped)
+    {
+        settled = true;
+        wakeMutex.unlock();
+        
+        if(moved)
+        {
+            moved = false;
+            application->layoutSettled();
+        }
+        
+        wakeMutex.lock();
+        
+        while(!woken && !stopped)
+        {
+            wakeCond.wait(wakeMutex);
+        }
+        
+        settled = false;
+    }
+    
+    wakeMutex.unlock();
+}
+
+// Graph edits wake with global false, they are listed by the graph and
+// may only need a local relaxation.
+void ArfLayout::wake(bool global)
+{
+    wakeMutex.lock();
+    woken = true;
+    globalWake = globalWake || global;
+    wakeCond.signal();
+    wakeMutex.unlock();
+}
+
+void ArfLayout::stop()
+{
+    stopped = true;
+    wake();
+    GraphLayout::stop();
+}
+
+// Spring and repulsion accelerations for a range of nodes, damping is left
+// to the integrator. Each node only writes its own entry, so any split
+// across threads gives the same result.
+class ArfStep : public ThreadPool::Task
+{
+private:
+    ArfLayout* layout;
+    Graph* graph;
+    const Octree& octree;
+    const vector<Vrui::Point>& positions;
+    const vector<char>& selected;
+    const vector<int>& nodes;
+    double repulsionConstant;
+    int selectedNode;
+    
+public:
+    vector<Vrui::Vector>& accelerations;
+    
+    ArfStep(ArfLayout* layout, Graph* graph, const Octree& octree, const vector<Vrui::Point>& positions,
+            const vector<char>& selected, const vector<int>& nodes, int selectedNode,
+            vector<Vrui::Vector>& accelerations)
+        : layout(layout),
+          graph(graph),
+          octree(octree),
+          positions(positions),
+          selected(selected),
+          nodes(nodes),
+          repulsionConstant(layout->layoutRadius * sqrt(graph->getNodeCount())),
+          selectedNode(selectedNode),
+          accelerations(accelerations)
+    {
+    }
+    
+    void run(int chunk, int begin, int end)
+    {
+        vector<int> neighbors;
+        
+        for(int i = begin; i < end && !layout->stopped; i++)
+        {
+            int source = nodes[i];
+            
+            if(source == selectedNode)
             {
                 continue;
             }
             
-            Vrui::Vector v = application->g->getNodePosition(source) - application->g->getNodePosition(target);
-            Vrui::Scalar mag = Geometry::mag(v);
+            // every pair as unconnected, far groups approximated
+            ArfInteraction interaction(positions, source, layout->unconnectedSpringConstant,
+                                       layout->unconnectedSpringLength, repulsionConstant, layout->beta);
+            octree.traverse(positions[source], layout->theta, interaction);
+            Vrui::Vector force = interaction.total;
             
-            int edgeCount = (int)application->g->hasEdge(source, target) + (int)application->g->hasEdge(target, source);
-            double springConstant = getSpringConstant(edgeCount);
-            double springLength = getSpringLength(edgeCount);
+            // swap the unconnected spring for the real one on each neighbor
+            neighbors.clear();
             
-            double constA = springConstant * (mag - springLength) / mag;
-            Vrui::Vector springForce = constA * v;
+            foreach(int edge, graph->getOutEdges(source))
+            {
+                neighbors.push_back(graph->getEdge(edge).target);
+            }
             
-            double constB = layoutRadius * sqrt(nodeCount) / pow(mag, 1 + beta);
-            Vrui::Vector repulsionForce = constB * v;
+            foreach(int edge, graph->getInEdges(source))
+            {
+                neighbors.push_back(graph->getEdge(edge).source);
+            }
+            
+            sort(neighbors.begin(), neighbors.end());
+            neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
+            
+            foreach(int target, neighbors)
+            {
+                if(!selected[target] || source == target)
+                {
+                    continue;
+                }
+                
+                Vrui::Vector v = positions[source] - positions[target];
+                Vrui::Scalar mag = Geometry::mag(v);
+                
+                if(mag == 0) continue;
+                
+                int edgeCount = (int)graph->hasEdge(source, target) + (int)graph->hasEdge(target, source);
+                double springConstant = layout->getSpringConstant(edgeCount);
+                double springLength = layout->getSpringLength(edgeCount);
+                
+                double constA = springConstant * (mag - springLength) / mag;
+                double constU = layout->unconnectedSpringConstant * (mag - layout->unconnectedSpringLength) / mag;
+                force += (constA - constU) * v;
+            }
+            
+            accelerations[source] = force / Vrui::Scalar(graph->getNodeSize(source)); // treat size as mass
+        }
+    }
+};
 
-            velocityVector[source] = VruiHelp::rk4(velocityVector[source], (dampingForce + springForce + repulsionForce) / mass, deltaTime);
-            positionVector[source] = VruiHelp::rk4(positionVector[source], velocity, deltaTime);
+// Returns the mean kinetic energy per moving node.
+const double ArfLayout::layoutStep()
+{
+    // copy-on-write snapshot, the graph may change while we work
+    application->g->lock();
+    *snapshot = *application->g;
+    application->g->unlock();
+    
+    int capacity = snapshot->getNodeCapacity();
+    const vector<Vrui::Point>& positions = snapshot->getNodePositions();
+    vector<Vrui::Vector> accelerations(capacity, Vrui::Vector(0, 0, 0));
+    vector<char> selected(capacity);
+    vector<int> nodes;
+    
+    foreach(int node, snapshot->getNodes())
+    {
+        if(application->isSelectedComponent(node))
+        {
+            nodes.push_back(node);
+            selected[node] = 1;
         }
     }
     
-    foreach(int node, application->g->getNodes())
+    // the region only changes with the seeds, frozen nodes never join it
+    if(incremental && regionDirty)
     {
-        application->g->updateNodeVelocity(node, velocityVector[node]);
-        application->g->updateNodePosition(node, positionVector[node]);
+        buildRegion(snapshot, selected);
     }
-}
+    
+    const vector<int>& active = incremental ? region : nodes;
+    
+    if(active.empty())
+    {
+        return 0;
+    }
+    
+    // frozen nodes still push on the active ones
+    octree.build(positions, nodes, vector<Vrui::Scalar>());
+    
+    int selectedNode = application->getSelectedNode();
+    ArfStep step(this, snapshot, octree, positions, selected, active, selectedNode, accelerations);
+    application->threadPool->parallelFor(active.size(), LAYOUT_GRAIN, step);
+    
+    if(stopped || nodes.size() < 2)
+    {
+        return 0;
+    }
+    
+    // Positions advance interactions times faster than velocities, a
+    // leftover of integrating once per pair that the tuned constants rely on.
+    Vrui::Scalar interactions = (int)nodes.size() - 1;
+    
+    // shrink the step until the largest acceleration moves a node at most MAX_STEP
+    Vrui::Scalar maxAcceleration = 0;
+    
+    foreach(int node, active)
+    {
+        maxAcceleration = max(maxAcceleration, Geometry::mag(accelerations[node]));
+    }
+    
+    Vrui::Scalar dt = deltaTime;
+    
+    if(interactions * maxAcceleration * dt * dt > MAX_STEP)
+    {
+        dt = sqrt(MAX_STEP / (interactions * maxAcceleration));
+    }
+    
+    Vrui::Scalar maxSpeed = MAX_STEP / (interactions * dt);
+    
+    // Semi-implicit Euler: damping is taken at the new velocity, which is
+    // stable for any step, then positions move with the new velocity.
+    vector<Vrui::Vector> positionVector(capacity, Vrui::Vector(0, 0, 0));
+    vector<Vrui::Vector> velocityVector(capacity, Vrui::Vector(0, 0, 0));
+    double energy = 0;
+    
+    foreach(int node, active)
+    {
+        if(node == selectedNode)
+        {
+            continue;
+        }
+        
+        double mass = snapshot->getNodeSize(node);
+        const Vrui::Vector& velocity = snapshot->getNodeVelocity(node);
+        Vrui::Scalar damping = 1 - dt * interactions * dampingConstant / mass;
+        Vrui::Vector newVelocity = (velocity + accelerations[node] * dt) / damping;
+        Vrui::Scalar speed = Geometry::mag(newVelocity);
+        
+        if(speed > maxSpeed)
+        {
+            newVelocity *= maxSpeed / speed;
+        }
+        
+        velocityVector[node] = newVelocity - velocity;
+        positionVector[node] = newVelocity * (dt * interactions);
+        energy += 0.5 * mass * Geometry::sqr(newVelocity);
+    }
+    
+    application->g->updateLayout(positionVector, velocityVector);
+    
+    return energy / active.size();
+}
\ No newline at end of file
@@ -23,17 +23,29 @@
 
 #include <graph.hpp>
 #include <mycelia.hpp>
+#include <threadpool.hpp>
 #include <layout/graphlayout.hpp>
+#include <layout/octree.hpp>
+
+#include <Threads/Cond.h>
+
+#define SETTLED_ENERGY 1e-4 // mean kinetic energy per node that counts as still
+#define SETTLED_STEPS 30 // still steps in a row before the layout sleeps
+#define MAX_STEP 0.25 // furthest a node may move in one step
+#define INCREMENTAL_HOPS 2 // neighborhood of a changed node that relaxes with it
+#define INCREMENTAL_STEPS 100 // step budget of a local relaxation
 
 class ArfLayout : public GraphLayout
 {
+    friend class ArfStep;
     friend class ArfWindow;
     
 private:
     double dampingConstant;
     double beta;
-    double deltaTime;
+    double deltaTime; // largest timestep, shortened under strong forces
     double layoutRadius;
+    double theta; // Barnes-Hut opening angle, 0 is exact
     
     double connectedSpringConstant;
     double stronglyConnectedSpringConstant;
@@ -43,15 +55,50 @@ private:
     double stronglyConnectedSpringLength;
     double unconnectedSpringLength;
     
+    Graph* snapshot;
+    Octree octree;
+    
+    // quiescence
+    Threads::Mutex wakeMutex;
+    Threads::Cond wakeCond;
+    bool woken; // since the current step began
+    bool globalWake; // some wake since the current step began wants every node
+    bool settled;
+    bool moved; // since the layout last slept, else waking it changed nothing
+    int stillSteps;
+    int runSteps; // since the layout last woke
+    int stepLimit; // steps before sleeping unsettled, 0 for none
+    
+    // Incremental mode: after the layout has rested, local edits only move
+    // the nodes within INCREMENTAL_HOPS of what changed. The rest of the
+    // graph still repels them but stays put.
+    bool resting; // slept since the last full run
+    bool incremental;
+    bool regionDirty;
+    int incrementalSteps;
+    std::vector<int> seeds; // changed nodes, sorted
+    std::vector<int> region; // seeds and their neighborhood, sorted
+    
+    void sleep();
+    void updateRegion(bool, bool, const std::vector<int>&);
+    void buildRegion(Graph*, const std::vector<char>&);
+    
 public:
     ArfLayout(Mycelia*);
+    ~ArfLayout();
     
     double getSpringConstant(int) const;
     double getSpringLength(int) const;
+    
+    const bool isSettled() const { return settled; }
+    void setStepLimit(int limit) { stepLimit = limit; }
+    virtual void getParameters(std::vector<double>&) const;
+    virtual void stop();
+    void wake(bool global = true);
 
 protected:
     virtual void* layout();
-    virtual void layoutStep();
+    virtual const double layoutStep();
 };
 
 #endif
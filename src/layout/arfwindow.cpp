@@ -44,6 +44,12 @@ ArfWindow::ArfWindow(Mycelia* application)
     betaSlider = p.second;
     betaSlider->getValueChangedCallbacks().add(this, &ArfWindow::sliderCallback);
     
+    // barnes-hut opening angle
+    p = VruiHelp::createParameter("Approximation", 0, 1.5, layout->theta, dialog);
+    thetaField = p.first;
+    thetaSlider = p.second;
+    thetaSlider->getValueChangedCallbacks().add(this, &ArfWindow::sliderCallback);
+    
     // strongly connected constant slider
     p = VruiHelp::createParameter("Strongly Connected Const", -5, -1, layout->stronglyConnectedSpringConstant, dialog);
     stronglyConnectedConstantField = p.first;
@@ -87,6 +93,11 @@ void ArfWindow::sliderCallback(GLMotif::Slider::ValueChangedCallbackData* cbData
         layout->beta = f;
         betaField->setValue(f);
     }
+    else if(cbData->slider == thetaSlider)
+    {
+        layout->theta = f;
+        thetaField->setValue(f);
+    }
     else if(cbData->slider == stronglyConnectedConstantSlider)
     {
         layout->stronglyConnectedSpringConstant = f;
@@ -102,4 +113,6 @@ void ArfWindow::sliderCallback(GLMotif::Slider::ValueChangedCallbackData* cbData
         layout->unconnectedSpringConstant = f;
         unconnectedConstantField->setValue(f);
     }
+    
+    layout->wake();
 }
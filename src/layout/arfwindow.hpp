@@ -33,6 +33,7 @@ private:
     GLMotif::Slider* dampingSlider;
     GLMotif::Slider* stepsizeSlider;
     GLMotif::Slider* betaSlider;
+    GLMotif::Slider* thetaSlider;
     GLMotif::Slider* stronglyConnectedConstantSlider;
     GLMotif::Slider* connectedConstantSlider;
     GLMotif::Slider* unconnectedConstantSlider;
@@ -43,6 +44,7 @@ private:
     GLMotif::TextField* dampingField;
     GLMotif::TextField* stepsizeField;
     GLMotif::TextField* betaField;
+    GLMotif::TextField* thetaField;
     GLMotif::TextField* stronglyConnectedConstantField;
     GLMotif::TextField* connectedConstantField;
     GLMotif::TextField* unconnectedConstantField;
@@ -0,0 +1,341 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <layout/componentlayout.hpp>
+
+using namespace std;
+
+ComponentLayout::ComponentLayout(Mycelia* application)
+    : GraphLayout(application)
+{
+    snapshot = new Graph(application);
+}
+
+ComponentLayout::~ComponentLayout()
+{
+    stop();
+    delete snapshot;
+}
+
+static bool largerComponent(const vector<int>* a, const vector<int>* b)
+{
+    return a->size() > b->size();
+}
+
+// Groups the selected nodes by connected component, ignoring direction.
+void ComponentLayout::split()
+{
+    vector<int> component(snapshot->getNodeCapacity(), -1);
+    vector<vector<int> > found;
+
+    foreach(int node, snapshot->getNodes())
+    {
+        if(component[node] != -1 || !application->isSelectedComponent(node)) continue;
+
+        int id = found.size();
+        found.push_back(vector<int>(1, node));
+        vector<int>& queue = found.back();
+        component[node] = id;
+
+        for(int head = 0; head < (int)queue.size(); head++)
+        {
+            int current = queue[head];
+
+            foreach(int edge, snapshot->getOutEdges(current))
+            {
+                int target = snapshot->getEdge(edge).target;
+
+                if(component[target] == -1 && application->isSelectedComponent(target))
+                {
+                    component[target] = id;
+                    queue.push_back(target);
+                }
+            }
+
+            foreach(int edge, snapshot->getInEdges(current))
+            {
+                int source = snapshot->getEdge(edge).source;
+
+                if(component[source] == -1 && application->isSelectedComponent(source))
+                {
+                    component[source] = id;
+                    queue.push_back(source);
+                }
+            }
+        }
+    }
+
+    // largest first, ties in the order found
+    vector<vector<int>*> order;
+
+    for(int c = 0; c < (int)found.size(); c++)
+    {
+        order.push_back(&found[c]);
+    }
+
+    stable_sort(order.begin(), order.end(), largerComponent);
+
+    components.resize(found.size());
+    index.assign(snapshot->getNodeCapacity(), -1);
+
+    for(int c = 0; c < (int)order.size(); c++)
+    {
+        components[c].swap(*order[c]);
+
+        for(int row = 0; row < (int)components[c].size(); row++)
+        {
+            index[components[c][row]] = row;
+        }
+    }
+
+    positions.assign(components.size(), vector<Vrui::Point>());
+}
+
+// Lays out one component, on the given pool or on this thread.
+void ComponentLayout::solve(int c, ThreadPool* threadPool)
+{
+    StressModel model(&stopped);
+    model.build(snapshot, components[c], index, start, threadPool);
+    model.solve(threadPool);
+    positions[c].swap(model.positions);
+}
+
+// Solves a range of small components, each on the calling thread.
+class ComponentSolve : public ThreadPool::Task
+{
+private:
+    ComponentLayout* layout;
+    int first;
+
+public:
+    ComponentSolve(ComponentLayout* layout, int first)
+        : layout(layout),
+          first(first)
+    {
+    }
+
+    void run(int chunk, int begin, int end)
+    {
+        for(int c = first + begin; c < first + end && !layout->stopped; c++)
+        {
+            layout->solve(c, 0);
+        }
+    }
+};
+
+// Moves each component's bounding sphere to its packed center.
+void ComponentLayout::pack()
+{
+    int count = components.size();
+    vector<Vrui::Point> centers(count);
+    vector<Vrui::Scalar> radii(count);
+
+    for(int c = 0; c < count; c++)
+    {
+        Vrui::Vector sum(0, 0, 0);
+
+        foreach(const Vrui::Point& p, positions[c])
+        {
+            sum += p - Vrui::Point::origin;
+        }
+
+        centers[c] = Vrui::Point::origin + sum / (Vrui::Scalar)positions[c].size();
+        radii[c] = 0;
+
+        foreach(const Vrui::Point& p, positions[c])
+        {
+            radii[c] = max(radii[c], Geometry::dist(p, centers[c]));
+        }
+
+        radii[c] += 0.5 * COMPONENT_GAP;
+    }
+
+    // evenly spread directions, on a Fibonacci spiral
+    vector<Vrui::Vector> directions(COMPONENT_DIRECTIONS);
+
+    for(int i = 0; i < COMPONENT_DIRECTIONS; i++)
+    {
+        Vrui::Scalar z = 1 - (2 * i + 1) / (Vrui::Scalar)COMPONENT_DIRECTIONS;
+        Vrui::Scalar r = sqrt(1 - z * z);
+        Vrui::Scalar theta = i * M_PI * (3 - sqrt(5.0));
+        directions[i] = Vrui::Vector(r * cos(theta), r * sin(theta), z);
+    }
+
+    vector<Vrui::Point> placed(count, Vrui::Point::origin);
+    vector<pair<Vrui::Scalar, Vrui::Scalar> > blocked;
+    int packed = min(count, COMPONENT_PACKED);
+
+    for(int c = 1; c < packed && !stopped; c++)
+    {
+        Vrui::Scalar best = -1;
+
+        foreach(const Vrui::Vector& u, directions)
+        {
+            // distances t along u where the sphere would overlap another
+            blocked.clear();
+
+            for(int other = 0; other < c; other++)
+            {
+                Vrui::Vector v = placed[other] - Vrui::Point::origin;
+                Vrui::Scalar reach = radii[c] + radii[other];
+                Vrui::Scalar b = u * v;
+                Vrui::Scalar disc = b * b - (v * v - reach * reach);
+
+                if(disc <= 0) continue;
+
+                Vrui::Scalar root = sqrt(disc);
+
+                if(b + root > 0) blocked.push_back(make_pair(b - root, b + root));
+            }
+
+            sort(blocked.begin(), blocked.end());
+
+            Vrui::Scalar t = 0;
+
+            for(int i = 0; i < (int)blocked.size() && blocked[i].first <= t; i++)
+            {
+                t = max(t, blocked[i].second);
+            }
+
+            if(best < 0 || t < best)
+            {
+                best = t;
+                placed[c] = Vrui::Point::origin + u * t;
+            }
+        }
+    }
+
+    packLattice(packed, radii, placed);
+
+    for(int c = 0; c < count; c++)
+    {
+        Vrui::Vector shift = placed[c] - centers[c];
+
+        foreach(Vrui::Point& p, positions[c])
+        {
+            p += shift;
+        }
+    }
+}
+
+static bool nearerCell(const pair<Vrui::Scalar, Vrui::Point>& a, const pair<Vrui::Scalar, Vrui::Point>& b)
+{
+    return a.first < b.first;
+}
+
+// Puts the components from first on in the cells of a lattice, the cells
+// as wide as the largest of them and outside every sphere packed before.
+void ComponentLayout::packLattice(int first, const vector<Vrui::Scalar>& radii, vector<Vrui::Point>& placed)
+{
+    int count = components.size();
+
+    if(first >= count) return;
+
+    Vrui::Scalar inner = 0;
+
+    for(int c = 0; c < first; c++)
+    {
+        inner = max(inner, Geometry::mag(placed[c] - Vrui::Point::origin) + radii[c]);
+    }
+
+    Vrui::Scalar cell = 2 * *max_element(radii.begin() + first, radii.end());
+    Vrui::Scalar reach = inner + 0.5 * cell; // nearest a cell's center may be
+    int needed = count - first;
+    vector<pair<Vrui::Scalar, Vrui::Point> > cells;
+
+    // grow the cube until enough of its cells clear the packed spheres
+    for(int extent = (int)ceil(reach / cell); (int)cells.size() < needed; extent++)
+    {
+        cells.clear();
+
+        for(int x = -extent; x <= extent; x++)
+        {
+            for(int y = -extent; y <= extent; y++)
+            {
+                for(int z = -extent; z <= extent; z++)
+                {
+                    Vrui::Point p(x * cell, y * cell, z * cell);
+                    Vrui::Scalar d = Geometry::mag(p - Vrui::Point::origin);
+
+                    if(d >= reach) cells.push_back(make_pair(d, p));
+                }
+            }
+        }
+    }
+
+    partial_sort(cells.begin(), cells.begin() + needed, cells.end(), nearerCell);
+
+    for(int c = first; c < count; c++)
+    {
+        placed[c] = cells[c - first].second;
+    }
+}
+
+void* ComponentLayout::layout()
+{
+    // copy-on-write snapshot, the graph may change while we work
+    application->g->lock();
+    *snapshot = *application->g;
+    application->g->unlock();
+
+    start = snapshot->getNodePositions();
+    split();
+
+    int count = components.size();
+    int shared = 0;
+
+    while(shared < count && (int)components[shared].size() > COMPONENT_SHARED_SIZE)
+    {
+        solve(shared++, application->threadPool);
+    }
+
+    ComponentSolve task(this, shared);
+    application->threadPool->parallelFor(count - shared, 1, task);
+
+    if(!stopped)
+    {
+        pack();
+
+        vector<int> nodes;
+        vector<Vrui::Point> packed;
+
+        for(int c = 0; c < count; c++)
+        {
+            nodes.insert(nodes.end(), components[c].begin(), components[c].end());
+            packed.insert(packed.end(), positions[c].begin(), positions[c].end());
+        }
+
+        application->g->setLayoutPositions(nodes, packed);
+    }
+
+    components.clear();
+    positions.clear();
+    index.clear();
+    start.clear();
+
+    // only complete runs are worth keeping
+    if(!stopped)
+    {
+        application->layoutFinished();
+    }
+
+    stopped = true;
+    application->resetNavigationCallback(0);
+
+    return 0;
+}
\ No newline at end of file
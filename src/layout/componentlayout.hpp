@@ -0,0 +1,73 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __COMPONENTLAYOUT_HPP
+#define __COMPONENTLAYOUT_HPP
+
+#include <graph.hpp>
+#include <mycelia.hpp>
+#include <threadpool.hpp>
+#include <layout/graphlayout.hpp>
+#include <layout/stresslayout.hpp>
+
+#define COMPONENT_SHARED_SIZE STRESS_EXACT_SIZE // larger components get the whole pool, one at a time
+#define COMPONENT_GAP 2 // space between packed components, in edge lengths
+#define COMPONENT_DIRECTIONS 32 // candidate directions when packing
+#define COMPONENT_PACKED 256 // largest components packed one by one, the rest go on a lattice
+
+/*
+ * Lays out every connected component on its own with the stress model and
+ * packs the results by bounding sphere. Components above
+ * COMPONENT_SHARED_SIZE run one after another, each spread over the thread
+ * pool; the rest run side by side, one component per task. The cost follows
+ * the sum over components instead of the whole graph, and small components
+ * no longer pull on the large ones.
+ *
+ * Packing goes from the largest sphere down. Each is put at the point
+ * nearest the origin, along one of COMPONENT_DIRECTIONS fixed directions,
+ * where it overlaps no sphere placed before it. That tests every sphere
+ * placed so far, so only the first COMPONENT_PACKED components are packed
+ * this way. The rest, often thousands of single nodes, fill the cells of a
+ * cubic lattice around them in one pass, nearest cells first.
+ */
+class ComponentLayout : public GraphLayout
+{
+    friend class ComponentSolve;
+
+private:
+    std::vector<std::vector<int> > components; // nodes of each, largest first
+    std::vector<std::vector<Vrui::Point> > positions; // of each component, same order
+    std::vector<int> index; // row of each node within its component
+    std::vector<Vrui::Point> start; // positions by node id
+
+    Graph* snapshot;
+
+    void split();
+    void solve(int, ThreadPool*);
+    void pack();
+    void packLattice(int, const std::vector<Vrui::Scalar>&, std::vector<Vrui::Point>&);
+
+public:
+    ComponentLayout(Mycelia*);
+    ~ComponentLayout();
+
+protected:
+    virtual void* layout();
+};
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <layout/cpulayout.hpp>
+
+// the CUDA build links gpulayout.cu instead
+#ifndef __CUDA__
+
+using namespace std;
+
+// Net force on a range of rows. Repulsion is summed one column tile at a
+// time, so a tile stays in cache while every row of the range visits it.
+// Each row only writes its own delta, any split gives the same result.
+class CpuLayoutStep : public ThreadPool::Task
+{
+private:
+    const PackedPoints& points;
+    const int* offsets;
+    const int* neighbors;
+    Vrui::Scalar k;
+    
+public:
+    vector<Vrui::Vector>& deltas;
+    
+    CpuLayoutStep(const PackedPoints& points, const int* offsets, const int* neighbors, Vrui::Scalar k,
+                  vector<Vrui::Vector>& deltas)
+        : points(points),
+          offsets(offsets),
+          neighbors(neighbors),
+          k(k),
+          deltas(deltas)
+    {
+    }
+    
+    void run(int chunk, int begin, int end)
+    {
+        int size = points.size();
+        
+        // repel, summed over both orderings of each pair
+        for(int tile = 0; tile < size; tile += LAYOUT_TILE)
+        {
+            int tileEnd = min(tile + LAYOUT_TILE, size);
+            
+            for(int i = begin; i < end; i++)
+            {
+                Vrui::Point p(points.x[i], points.y[i], points.z[i]);
+                deltas[i] += ForceKernel::repulsion(points, tile, tileEnd, p, points.weight[i], k * k,
+                                                    REPULSION_RADIUS);
+            }
+        }
+        
+        // attract along edges
+        for(int i = begin; i < end; i++)
+        {
+            Vrui::Point p(points.x[i], points.y[i], points.z[i]);
+            
+            for(int e = offsets[i]; e < offsets[i + 1]; e++)
+            {
+                int j = neighbors[e];
+                Vrui::Vector v = p - Vrui::Point(points.x[j], points.y[j], points.z[j]);
+                deltas[i] -= v * (Geometry::mag(v) / k);
+            }
+        }
+    }
+};
+
+extern "C"
+{
+    void gpuLayout(float4* positions_h, const int* offsets, const int* neighbors, int size, ThreadPool* threadPool)
+    {
+        if(size == 0) return;
+        
+        Vrui::Scalar k = pow(VOLUME / (Vrui::Scalar)size, 1 / 3.0);
+        
+        PackedPoints points;
+        
+        for(int i = 0; i < size; i++)
+        {
+            const float4& q = positions_h[i];
+            points.push_back(Vrui::Point(q.x, q.y, q.z), q.w);
+        }
+        
+        vector<Vrui::Vector> deltas(size);
+        CpuLayoutStep step(points, offsets, neighbors, k, deltas);
+        
+        for(int i = MAX_ITERATIONS; i >= 0; i--)
+        {
+            Vrui::Scalar t = MAX_DELTA * pow(i / (double)MAX_ITERATIONS, COOLING_EXPONENT);
+            
+            deltas.assign(size, Vrui::Vector(0, 0, 0));
+            threadPool->parallelFor(size, LAYOUT_GRAIN, step);
+            
+            // every delta is computed from the old positions, then all move
+            for(int j = 0; j < size; j++)
+            {
+                Vrui::Vector& delta = deltas[j];
+                Vrui::Scalar mag = Geometry::mag(delta);
+                
+                // scale if change is too large
+                if(mag > t)
+                {
+                    delta *= t / mag;
+                }
+                
+                points.x[j] += delta[0];
+                points.y[j] += delta[1];
+                points.z[j] += delta[2];
+            }
+        }
+        
+        for(int i = 0; i < size; i++)
+        {
+            positions_h[i].x = points.x[i];
+            positions_h[i].y = points.y[i];
+            positions_h[i].z = points.z[i];
+        }
+    }
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CPULAYOUT_HPP
+#define __CPULAYOUT_HPP
+
+#include <mycelia.hpp>
+#include <threadpool.hpp>
+#include <layout/forcekernel.hpp>
+#include <layout/frlayout.hpp>
+#include <layout/graphlayout.hpp>
+
+#ifdef __CUDA__
+#include <vector_types.h>
+#else
+// same layout as the CUDA type, position in xyz and degree in w
+struct float4
+{
+    float x;
+    float y;
+    float z;
+    float w;
+};
+#endif
+
+#define LAYOUT_TILE 1024 // columns per cache tile, 16 KB of packed points
+
+/*
+ * One shot Fruchterman-Reingold layout of a whole graph, on the GPU when
+ * built with CUDA and on the thread pool otherwise. Nodes are numbered
+ * 0..size-1; neighbors[offsets[i]..offsets[i+1]) lists the nodes i has an
+ * edge to or from, once per direction. Memory is linear in nodes + edges.
+ */
+extern "C" { void gpuLayout(float4*, const int*, const int*, int, ThreadPool*); }
+
+#endif
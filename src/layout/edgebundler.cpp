@@ -21,139 +21,702 @@
 using namespace std;
 
 EdgeBundler::EdgeBundler(Mycelia* application)
-    : GraphLayout(application)
+    : GraphLayout(application),
+      mode(BUNDLE_PAIRWISE),
+      segments(0),
+      stride(0),
+      current(0)
 {
 }
 
-void EdgeBundler::allocateSegments()
+// Rows for every edge, laid out straight between their endpoints. The
+// renderer may still be drawing the last run, so the new rows are built
+// aside and replace the old ones in one swap.
+void EdgeBundler::allocateSegments(int count, int width)
 {
-    // calculate maximum subdivisions
-    int maxSegments = 2; // endpoints
-    
-    for(int i = 0; i <= MAX_CYCLE; i++)
+    vector<int> newSlots(application->g->getEdgeCapacity(), -1);
+    vector<Vrui::Point> newBuffers[2];
+
+    for(int row = 0; row < (int)edges.size(); row++)
     {
-        maxSegments += pow(2.0, i);
+        newSlots[edges[row]] = row;
     }
-    
-    // allocate per-edge segment vector
-    segmentVector = vector<vector<Vrui::Point> >(application->g->getEdgeCount());
-    
-    for(int edge = 0; edge < application->g->getEdgeCount(); edge++)
+
+    for(int i = 0; i < 2; i++)
     {
-        segmentVector[edge] = vector<Vrui::Point>(maxSegments);
-        
-        for(int segment = 0; segment < maxSegments; segment++)
+        newBuffers[i].assign(edges.size() * width, Vrui::Point(0, 0, 0));
+    }
+
+    vector<Vrui::Point>& points = newBuffers[0];
+
+    for(int row = 0; row < (int)edges.size(); row++)
+    {
+        for(int segment = 0; segment <= count + 1; segment++)
         {
-            segmentVector[edge][segment] = Vrui::Point(numeric_limits<float>::max(), 0, 0);
+            Vrui::Scalar t = segment / (Vrui::Scalar)(count + 1);
+            points[row * width + segment] = sources[row] + (targets[row] - sources[row]) * t;
         }
     }
+
+    pointsMutex.lock();
+
+    slots.swap(newSlots);
+    buffers[0].swap(newBuffers[0]);
+    buffers[1].swap(newBuffers[1]);
+    segments = count;
+    stride = width;
+    current = 0;
+
+    pointsMutex.unlock();
+}
+
+/*
+ * compatibility
+ */
+
+// uniform grid over edge midpoints, rows bucketed by cell
+struct BundleGrid
+{
+    Vrui::Point origin;
+    Vrui::Scalar cell;
+    int size[3];
+    vector<int> offsets;
+    vector<int> rows;
+
+    const int cellOf(const Vrui::Point& p, int axis) const
+    {
+        return max(0, min(size[axis] - 1, (int)((p[axis] - origin[axis]) / cell)));
+    }
+
+    const int index(int x, int y, int z) const
+    {
+        return (z * size[1] + y) * size[0] + x;
+    }
+};
+
+// Angle, scale, position and visibility compatibility of two rows, and
+// whether the second runs against the first. Stops at zero as soon as the
+// product falls below COMPATIBILITY_MIN, every factor being at most one.
+const float EdgeBundler::compatibility(int first, int second, bool& reversed) const
+{
+    Vrui::Vector p = targets[first] - sources[first];
+    Vrui::Vector q = targets[second] - sources[second];
+    Vrui::Scalar pLength = Geometry::mag(p);
+    Vrui::Scalar qLength = Geometry::mag(q);
+
+    if(pLength == 0 || qLength == 0) return 0;
+
+    Vrui::Scalar dot = p * q;
+    reversed = dot < 0;
+
+    Vrui::Scalar average = (pLength + qLength) / 2;
+    Vrui::Scalar product = Math::abs(dot) / (pLength * qLength);
+
+    if(product < COMPATIBILITY_MIN) return 0;
+
+    product *= 2 / (average / min(pLength, qLength) + max(pLength, qLength) / average);
+
+    if(product < COMPATIBILITY_MIN) return 0;
+
+    Vrui::Point pMid = VruiHelp::midpoint(sources[first], targets[first]);
+    Vrui::Point qMid = VruiHelp::midpoint(sources[second], targets[second]);
+    product *= average / (average + Geometry::dist(pMid, qMid));
+
+    if(product < COMPATIBILITY_MIN) return 0;
+
+    // each edge projected onto the other's line should cover its midpoint
+    Vrui::Scalar visibility = 1;
+
+    for(int side = 0; side < 2; side++)
+    {
+        int a = side == 0 ? first : second;
+        int b = side == 0 ? second : first;
+        Vrui::Vector axis = (targets[a] - sources[a]) / (side == 0 ? pLength : qLength);
+
+        Vrui::Point i0 = sources[a] + axis * ((sources[b] - sources[a]) * axis);
+        Vrui::Point i1 = sources[a] + axis * ((targets[b] - sources[a]) * axis);
+        Vrui::Scalar span = Geometry::dist(i0, i1);
+
+        if(span == 0) return 0;
+
+        Vrui::Point aMid = VruiHelp::midpoint(sources[a], targets[a]);
+        Vrui::Scalar v = 1 - 2 * Geometry::dist(aMid, VruiHelp::midpoint(i0, i1)) / span;
+        visibility = min(visibility, max(v, 0.0));
+    }
+
+    return product * visibility;
+}
+
+// Fills the candidate list of a range of rows from the grid.
+class BundleCandidates : public ThreadPool::Task
+{
+private:
+    EdgeBundler* bundler;
+    const BundleGrid& grid;
+    const vector<Vrui::Point>& midpoints;
+    const vector<Vrui::Scalar>& reaches;
+
+public:
+    BundleCandidates(EdgeBundler* bundler, const BundleGrid& grid, const vector<Vrui::Point>& midpoints,
+                     const vector<Vrui::Scalar>& reaches)
+        : bundler(bundler),
+          grid(grid),
+          midpoints(midpoints),
+          reaches(reaches)
+    {
+    }
+
+    void run(int chunk, int begin, int end)
+    {
+        for(int row = begin; row < end && !bundler->stopped; row++)
+        {
+            vector<BundleCandidate>& list = bundler->candidates[row];
+            const Vrui::Point& m = midpoints[row];
+            Vrui::Scalar reach = reaches[row];
+
+            if(reach == 0) continue;
+
+            int low[3];
+            int high[3];
+
+            for(int axis = 0; axis < 3; axis++)
+            {
+                low[axis] = grid.cellOf(m - Vrui::Vector(reach, reach, reach), axis);
+                high[axis] = grid.cellOf(m + Vrui::Vector(reach, reach, reach), axis);
+            }
+
+            for(int z = low[2]; z <= high[2]; z++)
+            for(int y = low[1]; y <= high[1]; y++)
+            for(int x = low[0]; x <= high[0]; x++)
+            {
+                int cell = grid.index(x, y, z);
+
+                for(int i = grid.offsets[cell]; i < grid.offsets[cell + 1]; i++)
+                {
+                    int other = grid.rows[i];
+
+                    if(other == row || Geometry::sqrDist(m, midpoints[other]) > reach * reach) continue;
+
+                    BundleCandidate candidate;
+                    candidate.row = other;
+                    candidate.compatibility = bundler->compatibility(row, other, candidate.reversed);
+
+                    if(candidate.compatibility >= COMPATIBILITY_MIN) list.push_back(candidate);
+                }
+            }
+        }
+    }
+};
+
+void EdgeBundler::findEdges()
+{
+    edges = application->g->getEdges();
+    sources.resize(edges.size());
+    targets.resize(edges.size());
+
+    for(int row = 0; row < (int)edges.size(); row++)
+    {
+        sources[row] = application->g->getSourceNodePosition(edges[row]);
+        targets[row] = application->g->getTargetNodePosition(edges[row]);
+    }
+}
+
+void EdgeBundler::findCandidates()
+{
+    int rows = edges.size();
+    candidates.assign(rows, vector<BundleCandidate>());
+
+    if(rows == 0) return;
+
+    // Scale compatibility alone bounds the length ratio of a compatible
+    // pair, so their average length is at most s times this edge's, and
+    // position compatibility then bounds the distance between midpoints.
+    double t = COMPATIBILITY_MIN;
+    double s = ((1 - t) + sqrt((1 - t) * (1 - t) + t * t)) / t;
+
+    vector<Vrui::Point> midpoints(rows);
+    vector<Vrui::Scalar> reaches(rows);
+    Vrui::Point low = sources[0];
+    Vrui::Point high = low;
+    Vrui::Scalar total = 0;
+
+    for(int row = 0; row < rows; row++)
+    {
+        midpoints[row] = VruiHelp::midpoint(sources[row], targets[row]);
+        reaches[row] = s * Geometry::dist(sources[row], targets[row]) * (1 - t) / t;
+        total += reaches[row];
+
+        for(int axis = 0; axis < 3; axis++)
+        {
+            low[axis] = min(low[axis], midpoints[row][axis]);
+            high[axis] = max(high[axis], midpoints[row][axis]);
+        }
+    }
+
+    // cells about one reach across, but not too many of them
+    BundleGrid grid;
+    Vrui::Scalar extent = max(high[0] - low[0], max(high[1] - low[1], high[2] - low[2]));
+    grid.origin = low;
+    grid.cell = max(total / rows, extent / BUNDLE_GRID_CELLS);
+
+    if(grid.cell == 0) grid.cell = 1;
+
+    for(int axis = 0; axis < 3; axis++)
+    {
+        grid.size[axis] = min(BUNDLE_GRID_CELLS, (int)((high[axis] - low[axis]) / grid.cell) + 1);
+    }
+
+    int cells = grid.size[0] * grid.size[1] * grid.size[2];
+    vector<int> cellOf(rows);
+    grid.offsets.assign(cells + 1, 0);
+    grid.rows.resize(rows);
+
+    for(int row = 0; row < rows; row++)
+    {
+        const Vrui::Point& m = midpoints[row];
+        cellOf[row] = grid.index(grid.cellOf(m, 0), grid.cellOf(m, 1), grid.cellOf(m, 2));
+        grid.offsets[cellOf[row] + 1]++;
+    }
+
+    for(int cell = 0; cell < cells; cell++)
+    {
+        grid.offsets[cell + 1] += grid.offsets[cell];
+    }
+
+    vector<int> cursor(grid.offsets.begin(), grid.offsets.end() - 1);
+
+    for(int row = 0; row < rows; row++)
+    {
+        grid.rows[cursor[cellOf[row]]++] = row;
+    }
+
+    BundleCandidates task(this, grid, midpoints, reaches);
+    application->threadPool->parallelFor(rows, LAYOUT_GRAIN, task);
+}
+
+/*
+ * bundling
+ */
+// Doubles a range of rows' segments, new points halfway between the old.
+class BundleSubdivide : public ThreadPool::Task
+{
+private:
+    EdgeBundler* bundler;
+
+public:
+    BundleSubdivide(EdgeBundler* bundler) : bundler(bundler) {}
+
+    void run(int chunk, int begin, int end)
+    {
+        int count = bundler->segments + 2;
+        const vector<Vrui::Point>& points = bundler->buffers[bundler->current];
+        vector<Vrui::Point>& next = bundler->buffers[1 - bundler->current];
+
+        for(int row = begin; row < end; row++)
+        {
+            const Vrui::Point* from = &points[row * bundler->stride];
+            Vrui::Point* to = &next[row * bundler->stride];
+
+            for(int segment = 0; segment < count - 1; segment++)
+            {
+                to[2 * segment] = from[segment];
+                to[2 * segment + 1] = VruiHelp::midpoint(from[segment], from[segment + 1]);
+            }
+
+            to[2 * (count - 1)] = from[count - 1];
+        }
+    }
+};
+
+void EdgeBundler::subdivide()
+{
+    BundleSubdivide task(this);
+    application->threadPool->parallelFor(edges.size(), LAYOUT_GRAIN, task);
+
+    // flipped first, a renderer reading the count before the points then
+    // never reads past the ones written
+    current = 1 - current;
+    segments = 2 * segments + 1;
 }
 
 void* EdgeBundler::layout()
 {
+    findEdges();
+
+    if(mode == BUNDLE_DENSITY)
+    {
+        bundleByDensity();
+        return 0;
+    }
+
     cycle = 0;
-    segments = SUBDIVISIONS_0;
     stepsize = STEPSIZE_0;
     iterations = ITERATIONS_0;
-    allocateSegments();
+    findCandidates();
+    allocateSegments(SUBDIVISIONS_0, BUNDLE_STRIDE);
     
-    while(cycle <= MAX_CYCLE && !stopped)
+    while(!stopped)
     {
-        for(int iteration = 0; iteration < iterations; iteration++)
+        for(int iteration = 0; iteration < iterations && !stopped; iteration++)
         {
             layoutStep();
-            application->g->update();
+            application->g->redraw();
         }
+
+        // the renderer keeps drawing the last cycle's points
+        if(cycle == MAX_CYCLE) break;
         
         cycle++;
-        segments += pow(2.0, cycle);
+        subdivide();
         stepsize /= 2.0;
         iterations *= 0.66;
     }
+
+    candidates.clear();
+
     return 0;
 }
 
-void EdgeBundler::layoutStep()
+// Moves a range of rows' points into the other buffer, endpoints as they are.
+class BundleStep : public ThreadPool::Task
 {
-    for(int firstEdge = 0; firstEdge < (int)application->g->getEdgeCount(); firstEdge++)
+private:
+    EdgeBundler* bundler;
+
+public:
+    BundleStep(EdgeBundler* bundler) : bundler(bundler) {}
+
+    void run(int chunk, int begin, int end)
     {
-        Vrui::Scalar k_p = K / Geometry::abs(application->g->getSourceNodePosition(firstEdge) - application->g->getTargetNodePosition(firstEdge));
-        
-        for(int segment = 1; *getSegment(firstEdge, segment) != application->g->getTargetNodePosition(firstEdge); segment++)
+        int segments = bundler->segments;
+        const vector<Vrui::Point>& points = bundler->buffers[bundler->current];
+        vector<Vrui::Point>& next = bundler->buffers[1 - bundler->current];
+
+        for(int row = begin; row < end && !bundler->stopped; row++)
         {
-            Vrui::Point& p_prev     = *getSegment(firstEdge, segment - 1);
-            Vrui::Point& p          = *getSegment(firstEdge, segment);
-            Vrui::Point& p_next     = *getSegment(firstEdge, segment + 1);
-            
-            Vrui::Vector F_s_prev_v = p_prev - p;
-            Vrui::Vector F_s_next_v = p_next - p;
-            Vrui::Vector F_s_v      = (F_s_prev_v + F_s_next_v) * k_p;
-            Vrui::Vector F_e_v      = Vrui::Vector(0, 0, 0);
-            
-            for(int secondEdge = 0; secondEdge < application->g->getEdgeCount(); secondEdge++)
+            const Vrui::Point* first = &points[row * bundler->stride];
+            Vrui::Point* moved = &next[row * bundler->stride];
+            Vrui::Scalar length = Geometry::dist(bundler->sources[row], bundler->targets[row]);
+
+            copy(first, first + segments + 2, moved);
+
+            if(length == 0) continue;
+
+            Vrui::Scalar k_p = K / length;
+
+            for(int segment = 1; segment <= segments; segment++)
             {
-                if(firstEdge == secondEdge) continue;
-                
-                Vrui::Point& q = *getSegment(secondEdge, segment);
-                Vrui::Vector v = q - p;
-                Vrui::Scalar mag = Geometry::mag(v);
-                
+                const Vrui::Point& p_prev = first[segment - 1];
+                const Vrui::Point& p      = first[segment];
+                const Vrui::Point& p_next = first[segment + 1];
+
+                Vrui::Vector F_s_prev_v = p_prev - p;
+                Vrui::Vector F_s_next_v = p_next - p;
+                Vrui::Vector F_s_v      = (F_s_prev_v + F_s_next_v) * k_p;
+                Vrui::Vector F_e_v      = Vrui::Vector(0, 0, 0);
+
+                foreach(const BundleCandidate& candidate, bundler->candidates[row])
+                {
+                    int match = candidate.reversed ? segments + 1 - segment : segment;
+
+                    const Vrui::Point& q = points[candidate.row * bundler->stride + match];
+                    Vrui::Vector v = q - p;
+                    Vrui::Scalar mag = Geometry::mag(v);
+
+                    if(mag > 0)
+                    {
+                        Vrui::Vector F_e_v_delta = v / (mag * mag * mag); // power 2=linear, 3=quadratic
+                        F_e_v += F_e_v_delta * (Vrui::Scalar)candidate.compatibility;
+                    }
+                }
+
+                Vrui::Vector F_v    = F_s_v + F_e_v;
+                Vrui::Scalar mag    = Geometry::mag(F_v);
+
                 if(mag > 0)
                 {
-                    Vrui::Vector F_e_v_delta = v / Math::pow(mag, 3); // power 2=linear, 3=quadratic
-                    F_e_v += F_e_v_delta;
+                    if(mag > 1) F_v = F_v.normalize();
+                    moved[segment] += F_v * bundler->stepsize;
                 }
             }
-            
-            Vrui::Vector force  = Vrui::Vector(0, 0, 0);
-            Vrui::Vector F_v    = F_s_v + F_e_v;
-            Vrui::Scalar mag    = Geometry::mag(F_v);
-            
-            if(mag > 0)
-            {
-                if(mag > 1) F_v = F_v.normalize();
-                force += F_v * stepsize;
-            }
-            
-            p += force;
         }
     }
+};
+
+void EdgeBundler::layoutStep()
+{
+    BundleStep step(this);
+    application->threadPool->parallelFor(edges.size(), LAYOUT_GRAIN, step);
+
+    if(stopped) return;
+
+    current = 1 - current;
 }
 
-inline int EdgeBundler::getIndex(int i) const
+/*
+ * density
+ */
+const int EdgeBundler::gridCellOf(const Vrui::Point& p, int axis) const
 {
-    return i * pow(2.0, MAX_CYCLE - cycle);
+    return max(0, min(gridSize[axis] - 1, (int)floor((p[axis] - gridOrigin[axis]) / gridCell)));
 }
 
-Vrui::Point* EdgeBundler::getSegment(int edge, int segment)
+// Counts the interior points in each cell.
+void EdgeBundler::splat()
 {
-    int index = getIndex(segment);
-    
-    if(isSegmentEmpty(edge, index))
+    const vector<Vrui::Point>& points = buffers[current];
+    fill(density.begin(), density.end(), 0.0f);
+
+    for(int row = 0; row < (int)edges.size(); row++)
     {
-        if(segment == 0)
+        for(int segment = 1; segment <= segments; segment++)
         {
-            segmentVector[edge][index] = Vrui::Point(application->g->getSourceNodePosition(edge));
+            const Vrui::Point& p = points[row * stride + segment];
+            int x = gridCellOf(p, 0);
+            int y = gridCellOf(p, 1);
+            int z = gridCellOf(p, 2);
+
+            density[(z * gridSize[1] + y) * gridSize[0] + x] += 1;
         }
-        else if(segment > segments)
+    }
+}
+
+// Convolves a range of grid lines along one axis with a parabolic kernel.
+class DensityBlur : public ThreadPool::Task
+{
+private:
+    EdgeBundler* bundler;
+    int axis;
+    vector<float> weights;
+
+public:
+    DensityBlur(EdgeBundler* bundler, int axis, Vrui::Scalar radius)
+        : bundler(bundler),
+          axis(axis)
+    {
+        int reach = (int)ceil(radius);
+
+        for(int k = -reach; k <= reach; k++)
         {
-            segmentVector[edge][index] = Vrui::Point(application->g->getTargetNodePosition(edge));
+            weights.push_back(1 - (k * k) / ((radius + 1) * (radius + 1)));
         }
-        else
+    }
+
+    const int getLines() const
+    {
+        const int* size = bundler->gridSize;
+        return size[0] * size[1] * size[2] / size[axis];
+    }
+
+    void run(int chunk, int begin, int end)
+    {
+        const int* size = bundler->gridSize;
+        int length = size[axis];
+        int stride = axis == 0 ? 1 : axis == 1 ? size[0] : size[0] * size[1];
+        int reach = weights.size() / 2;
+        vector<float>& density = bundler->density;
+        vector<float> line(length);
+
+        for(int l = begin; l < end; l++)
         {
-            segmentVector[edge][index] = VruiHelp::midpoint(*getSegment(edge, segment - 1), *getSegment(edge, segment + 1));
+            // the line's first cell, from its coordinates on the other two axes
+            int a = l % size[axis == 0 ? 1 : 0];
+            int b = l / size[axis == 0 ? 1 : 0];
+            int first = axis == 0 ? (b * size[1] + a) * size[0]
+                      : axis == 1 ? b * size[0] * size[1] + a
+                      : b * size[0] + a;
+
+            for(int i = 0; i < length; i++)
+            {
+                line[i] = density[first + i * stride];
+            }
+
+            for(int i = 0; i < length; i++)
+            {
+                float sum = 0;
+
+                for(int k = max(-reach, -i); k <= reach && i + k < length; k++)
+                {
+                    sum += weights[k + reach] * line[i + k];
+                }
+
+                density[first + i * stride] = sum;
+            }
         }
     }
-    
-    return &segmentVector[edge][index];
+};
+
+// Gradient of the trilinear interpolation of the density between cell centers.
+const Vrui::Vector EdgeBundler::densityGradient(const Vrui::Point& p) const
+{
+    int low[3];
+    int high[3];
+    Vrui::Scalar t[3];
+
+    for(int axis = 0; axis < 3; axis++)
+    {
+        Vrui::Scalar f = (p[axis] - gridOrigin[axis]) / gridCell - 0.5;
+        int i = (int)floor(f);
+        t[axis] = f - i;
+        low[axis] = max(0, min(gridSize[axis] - 1, i));
+        high[axis] = max(0, min(gridSize[axis] - 1, i + 1));
+    }
+
+    float c[2][2][2];
+
+    for(int z = 0; z < 2; z++)
+    for(int y = 0; y < 2; y++)
+    for(int x = 0; x < 2; x++)
+    {
+        int cell = ((z ? high[2] : low[2]) * gridSize[1] + (y ? high[1] : low[1])) * gridSize[0]
+                 + (x ? high[0] : low[0]);
+        c[z][y][x] = density[cell];
+    }
+
+    Vrui::Vector g(0, 0, 0);
+
+    for(int z = 0; z < 2; z++)
+    for(int y = 0; y < 2; y++)
+    {
+        Vrui::Scalar w = (z ? t[2] : 1 - t[2]) * (y ? t[1] : 1 - t[1]);
+        g[0] += w * (c[z][y][1] - c[z][y][0]);
+    }
+
+    for(int z = 0; z < 2; z++)
+    for(int x = 0; x < 2; x++)
+    {
+        Vrui::Scalar w = (z ? t[2] : 1 - t[2]) * (x ? t[0] : 1 - t[0]);
+        g[1] += w * (c[z][1][x] - c[z][0][x]);
+    }
+
+    for(int y = 0; y < 2; y++)
+    for(int x = 0; x < 2; x++)
+    {
+        Vrui::Scalar w = (y ? t[1] : 1 - t[1]) * (x ? t[0] : 1 - t[0]);
+        g[2] += w * (c[1][y][x] - c[0][y][x]);
+    }
+
+    return g;
 }
 
-int EdgeBundler::getSegmentCount() const
+// Moves a range of rows' interior points up the gradient, then smooths
+// them along the edge, into the other buffer.
+class DensityAdvect : public ThreadPool::Task
 {
-    return segments;
+private:
+    EdgeBundler* bundler;
+    Vrui::Scalar step;
+
+public:
+    DensityAdvect(EdgeBundler* bundler, Vrui::Scalar step)
+        : bundler(bundler),
+          step(step)
+    {
+    }
+
+    void run(int chunk, int begin, int end)
+    {
+        int count = bundler->segments + 2;
+        const vector<Vrui::Point>& points = bundler->buffers[bundler->current];
+        vector<Vrui::Point>& next = bundler->buffers[1 - bundler->current];
+        vector<Vrui::Point> moved(count);
+
+        for(int row = begin; row < end && !bundler->stopped; row++)
+        {
+            const Vrui::Point* first = &points[row * bundler->stride];
+            Vrui::Point* to = &next[row * bundler->stride];
+
+            for(int segment = 0; segment < count; segment++)
+            {
+                moved[segment] = first[segment];
+
+                if(segment == 0 || segment == count - 1) continue;
+
+                Vrui::Vector g = bundler->densityGradient(first[segment]);
+                Vrui::Scalar mag = Geometry::mag(g);
+
+                if(mag > 0) moved[segment] += g * (step / mag);
+            }
+
+            to[0] = moved[0];
+            to[count - 1] = moved[count - 1];
+
+            for(int segment = 1; segment < count - 1; segment++)
+            {
+                Vrui::Point average = VruiHelp::midpoint(moved[segment - 1], moved[segment + 1]);
+                to[segment] = moved[segment] + (average - moved[segment]) * DENSITY_SMOOTHING;
+            }
+        }
+    }
+};
+
+void EdgeBundler::bundleByDensity()
+{
+    // straight, no cycles
+    allocateSegments(DENSITY_SEGMENTS, DENSITY_SEGMENTS + 2);
+
+    if(edges.empty()) return;
+
+    // grid over the endpoints, with room for the widest kernel around them
+    Vrui::Point low = sources[0];
+    Vrui::Point high = low;
+
+    for(int row = 0; row < (int)edges.size(); row++)
+    {
+        for(int axis = 0; axis < 3; axis++)
+        {
+            low[axis] = min(low[axis], min(sources[row][axis], targets[row][axis]));
+            high[axis] = max(high[axis], max(sources[row][axis], targets[row][axis]));
+        }
+    }
+
+    Vrui::Scalar extent = max(high[0] - low[0], max(high[1] - low[1], high[2] - low[2]));
+    gridCell = extent > 0 ? extent / DENSITY_GRID_CELLS : 1;
+
+    for(int axis = 0; axis < 3; axis++)
+    {
+        gridOrigin[axis] = low[axis] - DENSITY_RADIUS_0 * gridCell;
+        gridSize[axis] = (int)((high[axis] - low[axis]) / gridCell) + 1 + 2 * DENSITY_RADIUS_0;
+    }
+
+    density.resize(gridSize[0] * gridSize[1] * gridSize[2]);
+
+    Vrui::Scalar radius = DENSITY_RADIUS_0;
+
+    for(int iteration = 0; iteration < DENSITY_ITERATIONS && !stopped; iteration++)
+    {
+        splat();
+
+        for(int axis = 0; axis < 3; axis++)
+        {
+            DensityBlur blur(this, axis, radius);
+            application->threadPool->parallelFor(blur.getLines(), LAYOUT_GRAIN, blur);
+        }
+
+        DensityAdvect advect(this, DENSITY_STEP * radius * gridCell);
+        application->threadPool->parallelFor(edges.size(), LAYOUT_GRAIN, advect);
+
+        if(stopped) break;
+
+        current = 1 - current;
+        application->g->redraw();
+
+        radius = max(1.0, radius * DENSITY_DECAY);
+    }
+
+    vector<float>().swap(density);
 }
 
-inline bool EdgeBundler::isSegmentEmpty(int edge, int index) const
+// An edge's getSegmentCount() + 2 points, or null if it is not bundled.
+// Valid while the caller holds lockPoints().
+const Vrui::Point* EdgeBundler::getPoints(int edge) const
 {
-    return segmentVector[edge][index][0] == numeric_limits<float>::max();
+    if(edge < 0 || edge >= (int)slots.size() || slots[edge] == -1) return 0;
+
+    return &buffers[current][slots[edge] * stride];
 }
+
+int EdgeBundler::getSegmentCount() const
+{
+    return segments;
+}
\ No newline at end of file
@@ -21,6 +21,7 @@
 
 #include <graph.hpp>
 #include <mycelia.hpp>
+#include <threadpool.hpp>
 #include <vruihelp.hpp>
 #include <layout/graphlayout.hpp>
 
@@ -29,24 +30,103 @@
 #define ITERATIONS_0        50
 #define MAX_CYCLE           5
 #define K                   1.5     // higher = less bundling
+#define COMPATIBILITY_MIN   0.6     // edges less compatible than this do not attract
+#define BUNDLE_GRID_CELLS   64      // bound on the candidate grid's cells per axis
+#define BUNDLE_STRIDE       ((2 << MAX_CYCLE) + 1) // points per edge at the last cycle
+#define BUNDLE_PAIRWISE     0
+#define BUNDLE_DENSITY      1
+#define DENSITY_ITERATIONS  12
+#define DENSITY_SEGMENTS    15      // interior points per edge
+#define DENSITY_GRID_CELLS  128     // density grid cells along its longest axis
+#define DENSITY_RADIUS_0    6       // initial kernel radius, in cells
+#define DENSITY_DECAY       0.8     // kernel radius kept from one iteration to the next
+#define DENSITY_STEP        0.5     // advection per iteration, in kernel radii
+#define DENSITY_SMOOTHING   0.5     // weight of the neighbors' average after advection
 
+// an edge that attracts another, with its subdivision points in reverse
+// order when it runs the other way
+struct BundleCandidate
+{
+    int row;
+    float compatibility;
+    bool reversed;
+};
+
+/*
+ * Force directed edge bundling after Holten and van Wijk. Each edge is
+ * attracted only by edges whose angle, scale, position and visibility
+ * compatibility, multiplied together, reaches COMPATIBILITY_MIN, and in
+ * proportion to it. The candidates are found once per run: the threshold
+ * bounds how far apart two compatible midpoints can be, so only nearby
+ * cells of a uniform grid over the midpoints are searched.
+ *
+ * Each step moves every edge's points against the positions of the
+ * previous step, in parallel over edges.
+ *
+ * BUNDLE_DENSITY replaces the pairwise forces with kernel density
+ * estimation after Hurter, Ersoy and Telea, for graphs too large for any
+ * pairwise scheme. Every iteration counts the points falling in each cell
+ * of a uniform grid, blurs the counts with a separable kernel whose radius
+ * shrinks each time, moves every point a fixed distance up the density
+ * gradient, and smooths each edge. The cost is linear in points and cells.
+ *
+ * Points live in two flat buffers, a fixed stride per bundled edge that
+ * is enough for the mode's finest subdivision; the first
+ * getSegmentCount() + 2 of an edge's run are in use, endpoints included.
+ * A step or a subdivision writes the other buffer and then flips, so the
+ * renderer always reads a complete set. A new run builds its buffers
+ * aside and swaps them in under the points mutex, which the renderer
+ * holds while it reads.
+ */
 class EdgeBundler : public GraphLayout
 {
+    friend class BundleCandidates;
+    friend class BundleStep;
+    friend class BundleSubdivide;
+    friend class DensityAdvect;
+    friend class DensityBlur;
+
 private:
+    int mode;
     int segments;
     double stepsize;
     int iterations;
     int cycle;
-    std::vector<std::vector<Vrui::Point> > segmentVector;
-    
+
+    std::vector<int> edges; // edge of each row
+    std::vector<int> slots; // row of each edge id, -1 if not bundled
+    std::vector<Vrui::Point> sources; // endpoints of each row
+    std::vector<Vrui::Point> targets;
+    std::vector<std::vector<BundleCandidate> > candidates; // of each row
+    std::vector<Vrui::Point> buffers[2]; // stride points per row
+    int stride;
+    volatile int current; // buffer with the latest points
+    mutable Threads::Mutex pointsMutex; // guards replacing the buffers
+
+    std::vector<float> density; // x fastest
+    int gridSize[3];
+    Vrui::Point gridOrigin;
+    Vrui::Scalar gridCell;
+
+    void allocateSegments(int, int);
+    void findEdges();
+    void findCandidates();
+    const float compatibility(int, int, bool&) const;
+    void subdivide();
+
+    void bundleByDensity();
+    void splat();
+    const int gridCellOf(const Vrui::Point&, int) const;
+    const Vrui::Vector densityGradient(const Vrui::Point&) const;
+
 public:
     EdgeBundler(Mycelia*);
     
-    void allocateSegments();
-    int getIndex(int) const;
-    Vrui::Point* getSegment(int, int);
+    const Vrui::Point* getPoints(int) const;
     int getSegmentCount() const;
-    bool isSegmentEmpty(int, int) const;
+    void lockPoints() const { pointsMutex.lock(); }
+    void unlockPoints() const { pointsMutex.unlock(); }
+    void setMode(int m) { mode = m; }
 
 protected:
     virtual void* layout();
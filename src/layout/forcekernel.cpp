@@ -0,0 +1,591 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <layout/forcekernel.hpp>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FORCEKERNEL_X86
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+void PackedPoints::clear()
+{
+    x.clear();
+    y.clear();
+    z.clear();
+    weight.clear();
+}
+
+void PackedPoints::push_back(const Vrui::Point& p, Vrui::Scalar w)
+{
+    x.push_back(p[0]);
+    y.push_back(p[1]);
+    z.push_back(p[2]);
+    weight.push_back(w);
+}
+
+// Both force models reduced to per pair scale factors. For ARF the
+// repulsion term is evaluated on d^2, so exponent is -(1 + beta) / 2.
+struct KernelArgs
+{
+    float px, py, pz;
+
+    // repulsion
+    float degree;
+    float k2;
+    float inverseRadius;
+
+    // interaction
+    float springConstant;
+    float springLength;
+    float repulsionConstant;
+    float exponent;
+};
+
+// Copies a partial run into full width buffers. Missing lanes sit on the
+// position itself, so the zero distance test drops them.
+static void loadTail(const PackedPoints& points, int i, int end, const KernelArgs& a,
+                     float* x, float* y, float* z, float* w)
+{
+    for(int k = 0; k < FORCEKERNEL_WIDTH; k++)
+    {
+        bool live = i + k < end;
+        x[k] = live ? points.x[i + k] : a.px;
+        y[k] = live ? points.y[i + k] : a.py;
+        z[k] = live ? points.z[i + k] : a.pz;
+        w[k] = live ? points.weight[i + k] : 0;
+    }
+}
+
+/*
+ * scalar
+ */
+static void repulsionScalar(const PackedPoints& points, int begin, int end, const KernelArgs& a, float* f)
+{
+    float fx = 0, fy = 0, fz = 0;
+
+    for(int i = begin; i < end; i++)
+    {
+        float vx = a.px - points.x[i];
+        float vy = a.py - points.y[i];
+        float vz = a.pz - points.z[i];
+        float d2 = vx * vx + vy * vy + vz * vz;
+
+        if(d2 == 0) continue;
+
+        float s = a.k2 * (1 / d2 - sqrtf(d2) * a.inverseRadius) * (a.degree + points.weight[i]);
+        fx += vx * s;
+        fy += vy * s;
+        fz += vz * s;
+    }
+
+    f[0] = fx;
+    f[1] = fy;
+    f[2] = fz;
+}
+
+static void interactionScalar(const PackedPoints& points, int begin, int end, const KernelArgs& a, float* f)
+{
+    float fx = 0, fy = 0, fz = 0;
+
+    for(int i = begin; i < end; i++)
+    {
+        float vx = a.px - points.x[i];
+        float vy = a.py - points.y[i];
+        float vz = a.pz - points.z[i];
+        float d2 = vx * vx + vy * vy + vz * vz;
+
+        if(d2 == 0) continue;
+
+        float s = a.springConstant * (1 - a.springLength / sqrtf(d2)) + a.repulsionConstant * powf(d2, a.exponent);
+        fx += vx * s;
+        fy += vy * s;
+        fz += vz * s;
+    }
+
+    f[0] = fx;
+    f[1] = fy;
+    f[2] = fz;
+}
+
+#ifdef FORCEKERNEL_X86
+
+/*
+ * sse2
+ */
+__attribute__((target("sse2")))
+static inline __m128 selectSse2(__m128 mask, __m128 a, __m128 b)
+{
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+// log2 to about float precision for positive normal x
+__attribute__((target("sse2")))
+static inline __m128 log2Sse2(__m128 x)
+{
+    __m128i bits = _mm_castps_si128(x);
+    __m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+    __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007fffff)),
+                                             _mm_set1_epi32(0x3f800000)));
+
+    // keep the mantissa within [sqrt(1/2), sqrt(2)]
+    __m128 big = _mm_cmpgt_ps(m, _mm_set1_ps(1.41421356f));
+    m = selectSse2(big, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+    __m128 ef = _mm_add_ps(_mm_cvtepi32_ps(e), _mm_and_ps(big, _mm_set1_ps(1)));
+
+    // log2(m) = 2 / ln 2 * atanh((m - 1) / (m + 1))
+    __m128 t = _mm_div_ps(_mm_sub_ps(m, _mm_set1_ps(1)), _mm_add_ps(m, _mm_set1_ps(1)));
+    __m128 t2 = _mm_mul_ps(t, t);
+    __m128 p = _mm_set1_ps(1.0f / 7);
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(1.0f / 5));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(1.0f / 3));
+    p = _mm_add_ps(_mm_mul_ps(p, t2), _mm_set1_ps(1));
+
+    return _mm_add_ps(ef, _mm_mul_ps(_mm_mul_ps(t, p), _mm_set1_ps(2.88539008f)));
+}
+
+__attribute__((target("sse2")))
+static inline __m128 exp2Sse2(__m128 y)
+{
+    y = _mm_min_ps(_mm_max_ps(y, _mm_set1_ps(-126)), _mm_set1_ps(126));
+
+    __m128i n = _mm_cvtps_epi32(y); // nearest
+    __m128 x = _mm_mul_ps(_mm_sub_ps(y, _mm_cvtepi32_ps(n)), _mm_set1_ps(0.693147181f));
+
+    // e^x on [-ln 2 / 2, ln 2 / 2]
+    __m128 p = _mm_set1_ps(1.0f / 720);
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(1.0f / 120));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(1.0f / 24));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(1.0f / 6));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(0.5f));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(1));
+    p = _mm_add_ps(_mm_mul_ps(p, x), _mm_set1_ps(1));
+
+    __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(n, _mm_set1_epi32(127)), 23));
+    return _mm_mul_ps(p, scale);
+}
+
+// One iteration covers FORCEKERNEL_WIDTH targets as two 4 wide halves.
+__attribute__((target("sse2")))
+static void repulsionSse2(const PackedPoints& points, int begin, int end, const KernelArgs& a, float* f)
+{
+    __m128 px = _mm_set1_ps(a.px), py = _mm_set1_ps(a.py), pz = _mm_set1_ps(a.pz);
+    __m128 degree = _mm_set1_ps(a.degree);
+    __m128 k2 = _mm_set1_ps(a.k2);
+    __m128 inverseRadius = _mm_set1_ps(a.inverseRadius);
+    __m128 one = _mm_set1_ps(1);
+    __m128 zero = _mm_setzero_ps();
+    __m128 fx = zero, fy = zero, fz = zero;
+
+    float tx[FORCEKERNEL_WIDTH], ty[FORCEKERNEL_WIDTH], tz[FORCEKERNEL_WIDTH], tw[FORCEKERNEL_WIDTH];
+
+    for(int i = begin; i < end; i += FORCEKERNEL_WIDTH)
+    {
+        const float *x, *y, *z, *w;
+
+        if(i + FORCEKERNEL_WIDTH <= end)
+        {
+            x = &points.x[i];
+            y = &points.y[i];
+            z = &points.z[i];
+            w = &points.weight[i];
+        }
+        else
+        {
+            loadTail(points, i, end, a, tx, ty, tz, tw);
+            x = tx;
+            y = ty;
+            z = tz;
+            w = tw;
+        }
+
+        for(int h = 0; h < FORCEKERNEL_WIDTH; h += 4)
+        {
+            __m128 vx = _mm_sub_ps(px, _mm_loadu_ps(x + h));
+            __m128 vy = _mm_sub_ps(py, _mm_loadu_ps(y + h));
+            __m128 vz = _mm_sub_ps(pz, _mm_loadu_ps(z + h));
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+            __m128 live = _mm_cmpgt_ps(d2, zero);
+
+            d2 = selectSse2(live, d2, one);
+            __m128 s = _mm_sub_ps(_mm_div_ps(one, d2), _mm_mul_ps(_mm_sqrt_ps(d2), inverseRadius));
+            s = _mm_mul_ps(_mm_mul_ps(k2, s), _mm_add_ps(degree, _mm_loadu_ps(w + h)));
+            s = _mm_and_ps(live, s);
+
+            fx = _mm_add_ps(fx, _mm_mul_ps(vx, s));
+            fy = _mm_add_ps(fy, _mm_mul_ps(vy, s));
+            fz = _mm_add_ps(fz, _mm_mul_ps(vz, s));
+        }
+    }
+
+    float sx[4], sy[4], sz[4];
+    _mm_storeu_ps(sx, fx);
+    _mm_storeu_ps(sy, fy);
+    _mm_storeu_ps(sz, fz);
+
+    f[0] = sx[0] + sx[1] + sx[2] + sx[3];
+    f[1] = sy[0] + sy[1] + sy[2] + sy[3];
+    f[2] = sz[0] + sz[1] + sz[2] + sz[3];
+}
+
+__attribute__((target("sse2")))
+static void interactionSse2(const PackedPoints& points, int begin, int end, const KernelArgs& a, float* f)
+{
+    __m128 px = _mm_set1_ps(a.px), py = _mm_set1_ps(a.py), pz = _mm_set1_ps(a.pz);
+    __m128 springConstant = _mm_set1_ps(a.springConstant);
+    __m128 springLength = _mm_set1_ps(a.springLength);
+    __m128 repulsionConstant = _mm_set1_ps(a.repulsionConstant);
+    __m128 exponent = _mm_set1_ps(a.exponent);
+    __m128 one = _mm_set1_ps(1);
+    __m128 zero = _mm_setzero_ps();
+    __m128 fx = zero, fy = zero, fz = zero;
+
+    float tx[FORCEKERNEL_WIDTH], ty[FORCEKERNEL_WIDTH], tz[FORCEKERNEL_WIDTH], tw[FORCEKERNEL_WIDTH];
+
+    for(int i = begin; i < end; i += FORCEKERNEL_WIDTH)
+    {
+        const float *x, *y, *z;
+
+        if(i + FORCEKERNEL_WIDTH <= end)
+        {
+            x = &points.x[i];
+            y = &points.y[i];
+            z = &points.z[i];
+        }
+        else
+        {
+            loadTail(points, i, end, a, tx, ty, tz, tw);
+            x = tx;
+            y = ty;
+            z = tz;
+        }
+
+        for(int h = 0; h < FORCEKERNEL_WIDTH; h += 4)
+        {
+            __m128 vx = _mm_sub_ps(px, _mm_loadu_ps(x + h));
+            __m128 vy = _mm_sub_ps(py, _mm_loadu_ps(y + h));
+            __m128 vz = _mm_sub_ps(pz, _mm_loadu_ps(z + h));
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+            __m128 live = _mm_cmpgt_ps(d2, zero);
+
+            d2 = selectSse2(live, d2, one);
+            __m128 spring = _mm_sub_ps(one, _mm_div_ps(springLength, _mm_sqrt_ps(d2)));
+            __m128 repulsion = exp2Sse2(_mm_mul_ps(exponent, log2Sse2(d2)));
+            __m128 s = _mm_add_ps(_mm_mul_ps(springConstant, spring), _mm_mul_ps(repulsionConstant, repulsion));
+            s = _mm_and_ps(live, s);
+
+            fx = _mm_add_ps(fx, _mm_mul_ps(vx, s));
+            fy = _mm_add_ps(fy, _mm_mul_ps(vy, s));
+            fz = _mm_add_ps(fz, _mm_mul_ps(vz, s));
+        }
+    }
+
+    float sx[4], sy[4], sz[4];
+    _mm_storeu_ps(sx, fx);
+    _mm_storeu_ps(sy, fy);
+    _mm_storeu_ps(sz, fz);
+
+    f[0] = sx[0] + sx[1] + sx[2] + sx[3];
+    f[1] = sy[0] + sy[1] + sy[2] + sy[3];
+    f[2] = sz[0] + sz[1] + sz[2] + sz[3];
+}
+
+/*
+ * avx2
+ */
+__attribute__((target("avx2")))
+static inline __m256 log2Avx2(__m256 x)
+{
+    __m256i bits = _mm256_castps_si256(x);
+    __m256i e = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+    __m256 m = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                                                   _mm256_set1_epi32(0x3f800000)));
+
+    __m256 big = _mm256_cmp_ps(m, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+    m = _mm256_blendv_ps(m, _mm256_mul_ps(m, _mm256_set1_ps(0.5f)), big);
+    __m256 ef = _mm256_add_ps(_mm256_cvtepi32_ps(e), _mm256_and_ps(big, _mm256_set1_ps(1)));
+
+    __m256 t = _mm256_div_ps(_mm256_sub_ps(m, _mm256_set1_ps(1)), _mm256_add_ps(m, _mm256_set1_ps(1)));
+    __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 p = _mm256_set1_ps(1.0f / 7);
+    p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(1.0f / 5));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(1.0f / 3));
+    p = _mm256_add_ps(_mm256_mul_ps(p, t2), _mm256_set1_ps(1));
+
+    return _mm256_add_ps(ef, _mm256_mul_ps(_mm256_mul_ps(t, p), _mm256_set1_ps(2.88539008f)));
+}
+
+__attribute__((target("avx2")))
+static inline __m256 exp2Avx2(__m256 y)
+{
+    y = _mm256_min_ps(_mm256_max_ps(y, _mm256_set1_ps(-126)), _mm256_set1_ps(126));
+
+    __m256 n = _mm256_round_ps(y, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 x = _mm256_mul_ps(_mm256_sub_ps(y, n), _mm256_set1_ps(0.693147181f));
+
+    __m256 p = _mm256_set1_ps(1.0f / 720);
+    p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(1.0f / 120));
+    p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(1.0f / 24));
+    p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(1.0f / 6));
+    p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(0.5f));
+    p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(1));
+    p = _mm256_add_ps(_mm256_mul_ps(p, x), _mm256_set1_ps(1));
+
+    __m256i bias = _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127));
+    return _mm256_mul_ps(p, _mm256_castsi256_ps(_mm256_slli_epi32(bias, 23)));
+}
+
+__attribute__((target("avx2")))
+static inline void sumAvx2(__m256 fx, __m256 fy, __m256 fz, float* f)
+{
+    float sx[8], sy[8], sz[8];
+    _mm256_storeu_ps(sx, fx);
+    _mm256_storeu_ps(sy, fy);
+    _mm256_storeu_ps(sz, fz);
+
+    f[0] = f[1] = f[2] = 0;
+
+    for(int k = 0; k < 8; k++)
+    {
+        f[0] += sx[k];
+        f[1] += sy[k];
+        f[2] += sz[k];
+    }
+}
+
+__attribute__((target("avx2")))
+static void repulsionAvx2(const PackedPoints& points, int begin, int end, const KernelArgs& a, float* f)
+{
+    __m256 px = _mm256_set1_ps(a.px), py = _mm256_set1_ps(a.py), pz = _mm256_set1_ps(a.pz);
+    __m256 degree = _mm256_set1_ps(a.degree);
+    __m256 k2 = _mm256_set1_ps(a.k2);
+    __m256 inverseRadius = _mm256_set1_ps(a.inverseRadius);
+    __m256 one = _mm256_set1_ps(1);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 fx = zero, fy = zero, fz = zero;
+
+    float tx[FORCEKERNEL_WIDTH], ty[FORCEKERNEL_WIDTH], tz[FORCEKERNEL_WIDTH], tw[FORCEKERNEL_WIDTH];
+
+    for(int i = begin; i < end; i += FORCEKERNEL_WIDTH)
+    {
+        __m256 x, y, z, w;
+
+        if(i + FORCEKERNEL_WIDTH <= end)
+        {
+            x = _mm256_loadu_ps(&points.x[i]);
+            y = _mm256_loadu_ps(&points.y[i]);
+            z = _mm256_loadu_ps(&points.z[i]);
+            w = _mm256_loadu_ps(&points.weight[i]);
+        }
+        else
+        {
+            loadTail(points, i, end, a, tx, ty, tz, tw);
+            x = _mm256_loadu_ps(tx);
+            y = _mm256_loadu_ps(ty);
+            z = _mm256_loadu_ps(tz);
+            w = _mm256_loadu_ps(tw);
+        }
+
+        __m256 vx = _mm256_sub_ps(px, x);
+        __m256 vy = _mm256_sub_ps(py, y);
+        __m256 vz = _mm256_sub_ps(pz, z);
+        __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+        __m256 live = _mm256_cmp_ps(d2, zero, _CMP_GT_OQ);
+
+        d2 = _mm256_blendv_ps(one, d2, live);
+        __m256 s = _mm256_sub_ps(_mm256_div_ps(one, d2), _mm256_mul_ps(_mm256_sqrt_ps(d2), inverseRadius));
+        s = _mm256_mul_ps(_mm256_mul_ps(k2, s), _mm256_add_ps(degree, w));
+        s = _mm256_and_ps(live, s);
+
+        fx = _mm256_add_ps(fx, _mm256_mul_ps(vx, s));
+        fy = _mm256_add_ps(fy, _mm256_mul_ps(vy, s));
+        fz = _mm256_add_ps(fz, _mm256_mul_ps(vz, s));
+    }
+
+    sumAvx2(fx, fy, fz, f);
+}
+
+__attribute__((target("avx2")))
+static void interactionAvx2(const PackedPoints& points, int begin, int end, const KernelArgs& a, float* f)
+{
+    __m256 px = _mm256_set1_ps(a.px), py = _mm256_set1_ps(a.py), pz = _mm256_set1_ps(a.pz);
+    __m256 springConstant = _mm256_set1_ps(a.springConstant);
+    __m256 springLength = _mm256_set1_ps(a.springLength);
+    __m256 repulsionConstant = _mm256_set1_ps(a.repulsionConstant);
+    __m256 exponent = _mm256_set1_ps(a.exponent);
+    __m256 one = _mm256_set1_ps(1);
+    __m256 zero = _mm256_setzero_ps();
+    __m256 fx = zero, fy = zero, fz = zero;
+
+    float tx[FORCEKERNEL_WIDTH], ty[FORCEKERNEL_WIDTH], tz[FORCEKERNEL_WIDTH], tw[FORCEKERNEL_WIDTH];
+
+    for(int i = begin; i < end; i += FORCEKERNEL_WIDTH)
+    {
+        __m256 x, y, z;
+
+        if(i + FORCEKERNEL_WIDTH <= end)
+        {
+            x = _mm256_loadu_ps(&points.x[i]);
+            y = _mm256_loadu_ps(&points.y[i]);
+            z = _mm256_loadu_ps(&points.z[i]);
+        }
+        else
+        {
+            loadTail(points, i, end, a, tx, ty, tz, tw);
+            x = _mm256_loadu_ps(tx);
+            y = _mm256_loadu_ps(ty);
+            z = _mm256_loadu_ps(tz);
+        }
+
+        __m256 vx = _mm256_sub_ps(px, x);
+        __m256 vy = _mm256_sub_ps(py, y);
+        __m256 vz = _mm256_sub_ps(pz, z);
+        __m256 d2 = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(vx, vx), _mm256_mul_ps(vy, vy)), _mm256_mul_ps(vz, vz));
+        __m256 live = _mm256_cmp_ps(d2, zero, _CMP_GT_OQ);
+
+        d2 = _mm256_blendv_ps(one, d2, live);
+        __m256 spring = _mm256_sub_ps(one, _mm256_div_ps(springLength, _mm256_sqrt_ps(d2)));
+        __m256 repulsion = exp2Avx2(_mm256_mul_ps(exponent, log2Avx2(d2)));
+        __m256 s = _mm256_add_ps(_mm256_mul_ps(springConstant, spring), _mm256_mul_ps(repulsionConstant, repulsion));
+        s = _mm256_and_ps(live, s);
+
+        fx = _mm256_add_ps(fx, _mm256_mul_ps(vx, s));
+        fy = _mm256_add_ps(fy, _mm256_mul_ps(vy, s));
+        fz = _mm256_add_ps(fz, _mm256_mul_ps(vz, s));
+    }
+
+    sumAvx2(fx, fy, fz, f);
+}
+
+#endif
+
+/*
+ * dispatch
+ */
+static ForceKernel::Isa detectIsa()
+{
+#ifdef FORCEKERNEL_X86
+    __builtin_cpu_init();
+
+    if(__builtin_cpu_supports("avx2")) return ForceKernel::AVX2;
+    if(__builtin_cpu_supports("sse2")) return ForceKernel::SSE2;
+#endif
+
+    return ForceKernel::SCALAR;
+}
+
+static const ForceKernel::Isa isa = detectIsa();
+
+ForceKernel::Isa ForceKernel::getIsa()
+{
+    return isa;
+}
+
+const char* ForceKernel::getIsaName()
+{
+    switch(isa)
+    {
+    case AVX2:
+        return "avx2";
+        break;
+
+    case SSE2:
+        return "sse2";
+        break;
+
+    default:
+        return "scalar";
+        break;
+    }
+}
+
+Vrui::Vector ForceKernel::repulsion(const PackedPoints& points, int begin, int end, const Vrui::Point& p,
+                                    Vrui::Scalar degree, Vrui::Scalar k2, Vrui::Scalar radius)
+{
+    KernelArgs a;
+    a.px = p[0];
+    a.py = p[1];
+    a.pz = p[2];
+    a.degree = degree;
+    a.k2 = k2;
+    a.inverseRadius = 1 / radius;
+
+    float f[3] = {0, 0, 0};
+
+    if(begin < end)
+    {
+        switch(isa)
+        {
+#ifdef FORCEKERNEL_X86
+        case AVX2:
+            repulsionAvx2(points, begin, end, a, f);
+            break;
+
+        case SSE2:
+            repulsionSse2(points, begin, end, a, f);
+            break;
+#endif
+
+        default:
+            repulsionScalar(points, begin, end, a, f);
+            break;
+        }
+    }
+
+    return Vrui::Vector(f[0], f[1], f[2]);
+}
+
+Vrui::Vector ForceKernel::interaction(const PackedPoints& points, int begin, int end, const Vrui::Point& p,
+                                      Vrui::Scalar springConstant, Vrui::Scalar springLength,
+                                      Vrui::Scalar repulsionConstant, Vrui::Scalar beta)
+{
+    KernelArgs a;
+    a.px = p[0];
+    a.py = p[1];
+    a.pz = p[2];
+    a.springConstant = springConstant;
+    a.springLength = springLength;
+    a.repulsionConstant = repulsionConstant;
+    a.exponent = -(1 + beta) / 2;
+
+    float f[3] = {0, 0, 0};
+
+    if(begin < end)
+    {
+        switch(isa)
+        {
+#ifdef FORCEKERNEL_X86
+        case AVX2:
+            interactionAvx2(points, begin, end, a, f);
+            break;
+
+        case SSE2:
+            interactionSse2(points, begin, end, a, f);
+            break;
+#endif
+
+        default:
+            interactionScalar(points, begin, end, a, f);
+            break;
+        }
+    }
+
+    return Vrui::Vector(f[0], f[1], f[2]);
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FORCEKERNEL_HPP
+#define __FORCEKERNEL_HPP
+
+#include <mycelia.hpp>
+
+#define FORCEKERNEL_WIDTH 8 // targets per iteration
+
+/*
+ * Single precision copy of a set of points, one array per coordinate, laid
+ * out for the force kernels.
+ */
+class PackedPoints
+{
+public:
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> z;
+    std::vector<float> weight;
+
+    void clear();
+    void push_back(const Vrui::Point&, Vrui::Scalar);
+    const int size() const { return x.size(); }
+};
+
+/*
+ * Sums of pairwise forces from a run [begin, end) of packed points onto one
+ * position, FORCEKERNEL_WIDTH targets at a time. The instruction set (AVX2,
+ * SSE2 or plain scalar code) is picked once at startup. Points that coincide
+ * with the position contribute nothing.
+ */
+namespace ForceKernel
+{
+enum Isa
+{
+    SCALAR,
+    SSE2,
+    AVX2
+};
+
+Isa getIsa();
+const char* getIsaName();
+
+// Fruchterman-Reingold repulsion, v * k^2 (1 / d^2 - d / radius) (degree + weight)
+Vrui::Vector repulsion(const PackedPoints&, int, int, const Vrui::Point&, Vrui::Scalar degree,
+                       Vrui::Scalar k2, Vrui::Scalar radius);
+
+// attractive-repulsive force, v * (springConstant (d - springLength) / d + repulsionConstant / d^(1 + beta))
+Vrui::Vector interaction(const PackedPoints&, int, int, const Vrui::Point&, Vrui::Scalar springConstant,
+                         Vrui::Scalar springLength, Vrui::Scalar repulsionConstant, Vrui::Scalar beta);
+}
+
+#endif
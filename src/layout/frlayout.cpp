@@ -21,8 +21,17 @@
 using namespace std;
 
 FruchtermanReingoldLayout::FruchtermanReingoldLayout(Mycelia* application)
-    : GraphLayout(application)
+    : GraphLayout(application),
+      theta(THETA),
+      warmStart(false)
 {
+    snapshot = new Graph(application);
+}
+
+FruchtermanReingoldLayout::~FruchtermanReingoldLayout()
+{
+    stop();
+    delete snapshot;
 }
 
 void* FruchtermanReingoldLayout::layout()
@@ -33,11 +42,24 @@ void* FruchtermanReingoldLayout::layout()
         stopped = true;
         return 0;
     }
-    springForceConstant = Math::pow(VOLUME / numNodes, 1.0 / 3.0);
+    springForceConstant = Math::pow(VOLUME / (double)numNodes, 1.0 / 3.0);
+    temperature = warmStart ? min(WARM_TEMPERATURE * springForceConstant, (double)MAX_DELTA) : MAX_DELTA;
+    energy = numeric_limits<double>::max();
+    progress = 0;
     
+    // MAX_ITERATIONS is only a bound, most graphs settle well before it
     for(remainingIterations = MAX_ITERATIONS; remainingIterations > 0 && !stopped; remainingIterations--)
     {
-        layoutStep();
+        if(layoutStep() < CONVERGENCE_TOLERANCE * springForceConstant)
+        {
+            break;
+        }
+    }
+    
+    // only complete runs are worth keeping
+    if(!stopped)
+    {
+        application->layoutFinished();
     }
     
     stopped = true;
@@ -46,73 +68,160 @@ void* FruchtermanReingoldLayout::layout()
     return 0;
 }
 
-void FruchtermanReingoldLayout::layoutStep()
+// Forces on a range of nodes. Each node only gathers onto itself, following
+// its own edges in CSR order, so any split across threads gives the same sums.
+class FruchtermanReingoldStep : public ThreadPool::Task
 {
-    // temperature affects rate of movement, starts at 1 and moves gradually to 0
-    double temperature = MAX_DELTA * Math::pow(remainingIterations / (double)MAX_ITERATIONS, COOLING_EXPONENT);
-    vector<Vrui::Vector> forceVector(application->g->getNodeCount());
+private:
+    Graph* graph;
+    const Octree& octree;
+    const vector<Vrui::Point>& positions;
+    const vector<Vrui::Scalar>& degrees;
+    const vector<char>& selected;
+    const vector<int>& nodes;
+    double springForceConstant;
+    double theta;
+    double temperature;
     
-    // calculate repulsion between all nodes
-    foreach(int source, application->g->getNodes())
+    // attract connected nodes as distance^2 / k
+    inline void attract(int node, const Edge& e, int other, Vrui::Vector& force)
     {
-        if(!application->isSelectedComponent(source))
-        {
-            continue;
-        }
+        if(other == node || !selected[other]) return;
         
-        foreach(int target, application->g->getNodes())
+        Vrui::Vector v = positions[node] - positions[other];
+        Vrui::Scalar mag = Geometry::mag(v);
+        
+        if(mag > 0) v = v.normalize();
+        
+        force -= v * (mag * mag / springForceConstant * e.weight);
+    }
+    
+public:
+    vector<Vrui::Vector>& forceVector;
+    vector<Vrui::Scalar>& energies; // squared force before the temperature cap
+    
+    FruchtermanReingoldStep(Graph* graph, const Octree& octree, const vector<Vrui::Point>& positions,
+                            const vector<Vrui::Scalar>& degrees, const vector<char>& selected, const vector<int>& nodes,
+                            double springForceConstant, double theta, double temperature, vector<Vrui::Vector>& forceVector,
+                            vector<Vrui::Scalar>& energies)
+        : graph(graph),
+          octree(octree),
+          positions(positions),
+          degrees(degrees),
+          selected(selected),
+          nodes(nodes),
+          springForceConstant(springForceConstant),
+          theta(theta),
+          temperature(temperature),
+          forceVector(forceVector),
+          energies(energies)
+    {
+    }
+    
+    void run(int chunk, int begin, int end)
+    {
+        for(int i = begin; i < end; i++)
         {
-            if(!application->isSelectedComponent(target) || source == target)
-            {
-                continue;
-            }
+            int node = nodes[i];
             
-            // calculate repulsive force as k^2 / distance (or variant)
-            Vrui::Vector v = application->g->getNodePosition(source) - application->g->getNodePosition(target);
-            Vrui::Scalar mag = Geometry::mag(v);
+            // repulsion between all nodes, far away groups approximated
+            FruchtermanReingoldRepulsion repulsion(positions, degrees, springForceConstant, node);
+            octree.traverse(positions[node], theta, repulsion);
+            Vrui::Vector force = repulsion.total;
             
-            if(mag > 0) v = v.normalize();
-            else mag = 0.001;
+            foreach(int edge, graph->getOutEdges(node))
+            {
+                const Edge& e = graph->getEdge(edge);
+                attract(node, e, e.target, force);
+            }
             
-            Vrui::Scalar repulsiveForce = springForceConstant * springForceConstant * (1 / mag - mag * mag / REPULSION_RADIUS);
-            Vrui::Scalar weightedForce = repulsiveForce * application->g->getNodeDegree(source);
+            foreach(int edge, graph->getInEdges(node))
+            {
+                const Edge& e = graph->getEdge(edge);
+                attract(node, e, e.source, force);
+            }
             
-            forceVector[source] += v * weightedForce;
-            forceVector[target] -= v * weightedForce;
+            // dampen motion
+            Vrui::Scalar mag = force.mag();
+            energies[node] = mag * mag;
             
-            // attract connected nodes as distance^2 / k
-            if(application->g->hasEdge(source, target))
+            if(mag > temperature)
             {
-                Vrui::Scalar attractiveForce = mag * mag / springForceConstant;
-                float edgeWeights = 0;
-                
-                foreach(int edge, application->g->getEdges(source, target))
-                {
-                    edgeWeights += application->g->getEdgeWeight(edge);
-                }
-                
-                attractiveForce *= edgeWeights;
-                forceVector[source] -= v * attractiveForce;
-                forceVector[target] += v * attractiveForce;
+                force *= temperature / mag;
             }
+            
+            forceVector[node] = force;
         }
     }
-    
-    // dampen motion and update position
-    for(int node = 0; node < application->g->getNodeCount(); node++)
+};
+
+// Adaptive step control after Hu: the temperature grows after a run of
+// steps that lower the energy and shrinks after any step that does not.
+void FruchtermanReingoldLayout::updateTemperature(double newEnergy)
+{
+    if(newEnergy < energy)
     {
-        if(!application->isSelectedComponent(node))
+        if(++progress >= COOLING_PROGRESS)
         {
-            continue;
+            progress = 0;
+            temperature = min(temperature / COOLING_STEP, (double)MAX_DELTA);
         }
-        
-        Vrui::Scalar mag = forceVector[node].mag();
-        
-        if(mag > temperature)
+    }
+    else
+    {
+        progress = 0;
+        temperature *= COOLING_STEP;
+    }
+    
+    energy = newEnergy;
+}
+
+// Returns the mean distance moved by a node.
+const double FruchtermanReingoldLayout::layoutStep()
+{
+    // copy-on-write snapshot, the graph may change while we work
+    application->g->lock();
+    *snapshot = *application->g;
+    application->g->unlock();
+    
+    int capacity = snapshot->getNodeCapacity();
+    const vector<Vrui::Point>& positions = snapshot->getNodePositions();
+    vector<Vrui::Vector> forceVector(capacity);
+    vector<Vrui::Scalar> energies(capacity);
+    vector<Vrui::Scalar> degrees(capacity);
+    vector<char> selected(capacity);
+    vector<int> nodes;
+    
+    foreach(int node, snapshot->getNodes())
+    {
+        if(application->isSelectedComponent(node))
         {
-            forceVector[node] *= temperature / mag;
+            nodes.push_back(node);
+            degrees[node] = snapshot->getNodeDegree(node);
+            selected[node] = 1;
         }
-        
-        application->g->updateNodePosition(node, forceVector[node]);
     }
+    
+    octree.build(positions, nodes, degrees);
+    
+    FruchtermanReingoldStep step(snapshot, octree, positions, degrees, selected, nodes,
+                                 springForceConstant, theta, temperature, forceVector, energies);
+    application->threadPool->parallelFor(nodes.size(), LAYOUT_GRAIN, step);
+    
+    // update position
+    application->g->updateLayout(forceVector, vector<Vrui::Vector>());
+    
+    // summed in node order, the same for any thread count
+    double totalEnergy = 0;
+    double displacement = 0;
+    
+    foreach(int node, nodes)
+    {
+        totalEnergy += energies[node];
+        displacement += forceVector[node].mag();
+    }
+    
+    updateTemperature(totalEnergy);
+    
+    return nodes.empty() ? 0 : displacement / nodes.size();
 }
@@ -21,26 +21,97 @@
 
 #include <graph.hpp>
 #include <mycelia.hpp>
+#include <threadpool.hpp>
 #include <layout/graphlayout.hpp>
+#include <layout/octree.hpp>
 
 #define MAX_ITERATIONS 300
 #define MAX_DELTA 100
 #define COOLING_EXPONENT 1.5
+#define COOLING_STEP 0.9 // adaptive temperature factor per step
+#define COOLING_PROGRESS 5 // improving steps before the temperature rises
+#define CONVERGENCE_TOLERANCE 0.01 // mean step, in spring lengths, that ends the layout
 #define VOLUME 1000
 #define REPULSION_RADIUS 10000
+#define THETA 0.8 // Barnes-Hut opening angle, 0 is exact
+#define WARM_TEMPERATURE 5 // initial step, in spring lengths, from a placed start
+
+// Net repulsion on one node. Summed over both orderings of a pair, the
+// force between a and b is f(d) * (degree a + degree b), so far cells
+// contribute through both their plain and degree weighted centers. Leaves
+// go through the packed single precision kernel.
+class FruchtermanReingoldRepulsion
+{
+private:
+    Vrui::Point position;
+    Vrui::Scalar degree;
+    Vrui::Scalar k2;
+    
+    // repulsive force as k^2 / distance (or variant) along v
+    inline Vrui::Vector force(Vrui::Vector v) const
+    {
+        Vrui::Scalar mag = Geometry::mag(v);
+        
+        if(mag > 0) v = v.normalize();
+        else mag = 0.001;
+        
+        return v * (k2 * (1 / mag - mag * mag / REPULSION_RADIUS));
+    }
+    
+public:
+    Vrui::Vector total;
+    
+    FruchtermanReingoldRepulsion(const std::vector<Vrui::Point>& positions, const std::vector<Vrui::Scalar>& degrees,
+                                 Vrui::Scalar k, int node)
+        : position(positions[node]),
+          degree(degrees[node]),
+          k2(k * k),
+          total(0, 0, 0)
+    {
+    }
+    
+    void points(const PackedPoints& packed, int begin, int end)
+    {
+        total += ForceKernel::repulsion(packed, begin, end, position, degree, k2, REPULSION_RADIUS);
+    }
+    
+    void cell(const Octree::Cell& c)
+    {
+        total += force(position - c.center) * (degree * c.mass);
+        total += force(position - c.weightedCenter) * c.weight;
+    }
+};
 
 class FruchtermanReingoldLayout : public GraphLayout
 {
 private:
     int remainingIterations;
     double springForceConstant;
+    double theta;
+    
+    // adaptive cooling
+    double temperature;
+    double energy;
+    int progress;
+    bool warmStart; // positions already follow the graph, start cool
+    
+    Graph* snapshot;
+    Octree octree;
+    
+    void updateTemperature(double);
     
 public:
     FruchtermanReingoldLayout(Mycelia*);
+    ~FruchtermanReingoldLayout();
+    
+    double getTheta() const { return theta; }
+    void setTheta(double t) { theta = t; }
+    void setWarmStart(bool w) { warmStart = w; }
+    virtual void getParameters(std::vector<double>& parameters) const { parameters.push_back(theta); }
     
 protected:
     virtual void* layout();
-    virtual void layoutStep();
+    virtual const double layoutStep();
 };
 
 #endif
@@ -43,20 +43,12 @@ inline __host__ __device__ void operator+=(float4& p, float3 q)
 }
 
 __global__ void
-updatePositions(int size, float4* positions_d, float4* positions_delta_from, float4* positions_delta_to, float t)
+updatePositions(int size, float4* positions_d, float4* deltas_d, float t)
 {
-    // sum changes
-    int row = threadIdx.x;
-    float3 delta;
+    int i = blockIdx.x*blockDim.x + threadIdx.x;
+    if(i >= size) return;
     
-    for(int col = 0; col < size; col++)
-    {
-        // forces on i computed from i, j
-        delta += positions_delta_from[row*size + col];
-        
-        // forces on i computed from j, i
-        delta += positions_delta_to[col*size + row];
-    }
+    float3 delta = make_float3(deltas_d[i]);
     
     // scale if change is too large
     float mag = length(delta);
@@ -68,39 +60,46 @@ updatePositions(int size, float4* positions_d, float4* positions_delta_from, flo
     }
     
     // update position
-    positions_d[row] += delta;
+    positions_d[i] += delta;
 }
 
+// One thread per node, summing its own forces, so memory stays linear.
 __global__ void
-calculateForces(int size, float4* positions_d, float4* positions_delta_from, float4* positions_delta_to, int* adjacencies_d, float t, float k)
+calculateForces(int size, float4* positions_d, float4* deltas_d, int* offsets_d, int* neighbors_d, float k)
 {
     int i = blockIdx.x*blockDim.x + threadIdx.x;
-    int j = blockIdx.y*blockDim.y + threadIdx.y;
-    if(i == j || i >= size || j >= size) return;
+    if(i >= size) return;
     
-    // repel
-    float3 v = make_float3(positions_d[i]) - make_float3(positions_d[j]);
-    float mag = length(v);
-    v /= mag;
-    float f = k*k * (1/mag - mag*mag/REPULSION_RADIUS) * positions_d[i].w;
+    float3 p = make_float3(positions_d[i]);
+    float3 delta = make_float3(0, 0, 0);
     
-    // update relative change
-    int offset = i*size + j;
-    positions_delta_from[offset] += v * f;
-    positions_delta_to[offset] += v * -f;
+    // repel, summed over both orderings of each pair
+    for(int j = 0; j < size; j++)
+    {
+        float3 v = p - make_float3(positions_d[j]);
+        float mag = length(v);
+        if(mag == 0) continue;
+        
+        v /= mag;
+        delta += v * (k*k * (1/mag - mag*mag/REPULSION_RADIUS) * (positions_d[i].w + positions_d[j].w));
+    }
     
-    // attract if connected
-    f = (mag*mag/k) * adjacencies_d[offset]; // avoid conditional by setting force to 0 if not adjacent
+    // attract along edges, once per direction
+    for(int e = offsets_d[i]; e < offsets_d[i + 1]; e++)
+    {
+        float3 v = p - make_float3(positions_d[neighbors_d[e]]);
+        delta -= v * (length(v)/k);
+    }
     
-    // update relative change
-    positions_delta_from[offset] += v * -f;
-    positions_delta_to[offset] += v * f;
+    deltas_d[i] = make_float4(delta, 0);
 }
 
+class ThreadPool;
+
 extern "C"
 {
     __host__ void
-    gpuLayout(float4* positions_h, int* adjacencies_h, int size)
+    gpuLayout(float4* positions_h, const int* offsets_h, const int* neighbors_h, int size, ThreadPool*)
     {
         /*int device;
         struct cudaDeviceProp prop;
@@ -108,41 +107,42 @@ extern "C"
         CUDA_SAFE_CALL(cudaGetDeviceProperties(&prop, device));
         printf("%d %s %d.%d\n", device, prop.name, prop.major, prop.minor);*/
         
+        if(size == 0) return;
+        
         float k = pow(VOLUME/(float)size, 1/3.0f);
-        dim3 dimBlock(20, 20);
-        dim3 dimGrid((size+dimBlock.x-1) / dimBlock.x, (size+dimBlock.y-1) / dimBlock.y);
+        int edges = offsets_h[size];
+        dim3 dimBlock(256);
+        dim3 dimGrid((size+dimBlock.x-1) / dimBlock.x);
         
         float4* positions_d;
         CUDA_SAFE_CALL(cudaMalloc((void**)&positions_d, sizeof(float4)*size));
         cudaMemcpy(positions_d, positions_h, sizeof(float4)*size, cudaMemcpyHostToDevice);
         
-        float4* positions_delta_from;
-        CUDA_SAFE_CALL(cudaMalloc((void**)&positions_delta_from, sizeof(float4)*size*size));
+        float4* deltas_d;
+        CUDA_SAFE_CALL(cudaMalloc((void**)&deltas_d, sizeof(float4)*size));
         
-        float4* positions_delta_to;
-        CUDA_SAFE_CALL(cudaMalloc((void**)&positions_delta_to, sizeof(float4)*size*size));
+        int* offsets_d;
+        CUDA_SAFE_CALL(cudaMalloc((void**)&offsets_d, sizeof(int)*(size+1)));
+        cudaMemcpy(offsets_d, offsets_h, sizeof(int)*(size+1), cudaMemcpyHostToDevice);
         
-        int* adjacencies_d;
-        CUDA_SAFE_CALL(cudaMalloc((void**)&adjacencies_d, sizeof(int)*size*size));
-        cudaMemcpy(adjacencies_d, adjacencies_h, sizeof(int)*size*size, cudaMemcpyHostToDevice);
+        int* neighbors_d;
+        CUDA_SAFE_CALL(cudaMalloc((void**)&neighbors_d, sizeof(int)*(edges > 0 ? edges : 1)));
+        if(edges > 0) cudaMemcpy(neighbors_d, neighbors_h, sizeof(int)*edges, cudaMemcpyHostToDevice);
         
         for(int i = MAX_ITERATIONS; i >= 0; i--)
         {
             float t = MAX_DELTA * pow(i/(double)MAX_ITERATIONS, COOLING_EXPONENT);
             
-            cudaMemset(positions_delta_from, 0, sizeof(float4)*size*size);
-            cudaMemset(positions_delta_to, 0, sizeof(float4)*size*size);
-            
-            calculateForces<<<dimGrid, dimBlock>>>(size, positions_d, positions_delta_from, positions_delta_to, adjacencies_d, t, k);
-            updatePositions<<<1, size>>>(size, positions_d, positions_delta_from, positions_delta_to, t);
+            calculateForces<<<dimGrid, dimBlock>>>(size, positions_d, deltas_d, offsets_d, neighbors_d, k);
+            updatePositions<<<dimGrid, dimBlock>>>(size, positions_d, deltas_d, t);
             
             cudaThreadSynchronize();
         }
         
         cudaMemcpy(positions_h, positions_d, sizeof(float4)*size, cudaMemcpyDeviceToHost);
         cudaFree(positions_d);
-        cudaFree(positions_delta_from);
-        cudaFree(positions_delta_to);
-        cudaFree(adjacencies_d);
+        cudaFree(deltas_d);
+        cudaFree(offsets_d);
+        cudaFree(neighbors_d);
     }
 }
\ No newline at end of file
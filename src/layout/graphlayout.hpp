@@ -20,6 +20,9 @@
 #define __GRAPHLAYOUT_HPP
 
 #include <Threads/Thread.h>
+#include <vruihelp.hpp>
+
+#define LAYOUT_GRAIN 64 // nodes per thread pool chunk
 
 class Mycelia;
 
@@ -33,23 +36,36 @@ protected:
 
     virtual void* layout() = 0;
 
+    void* run()
+    {
+        VruiHelp::setRandomStream(RANDOM_STREAM_LAYOUT);
+        application->placeLayout(this);
+        return layout();
+    }
+
 public:
-    GraphLayout(Mycelia* application) : application(application), dynamic(false)
+    GraphLayout(Mycelia* application) : application(application), stopped(true), dynamic(false)
     {
         layoutThread = new Threads::Thread();
     }
+
+    // owners stop the layout first
+    virtual ~GraphLayout()
+    {
+        delete layoutThread;
+    }
     
     void start()
     {
         if (stopped)
         {
             stopped = false;
-            layoutThread->start(this, &GraphLayout::layout);
+            layoutThread->start(this, &GraphLayout::run);
         }
         // otherwise: do not start the thread again
     }
 
-    void stop()
+    virtual void stop()
     {
         stopped = true;
         
@@ -68,6 +84,11 @@ public:
     {
         return dynamic;
     }
+
+    // settings that change the result, for the layout cache
+    virtual void getParameters(std::vector<double>&) const
+    {
+    }
 };
 
 #endif
@@ -0,0 +1,384 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <layout/layoutcache.hpp>
+
+using namespace std;
+
+LayoutCache::LayoutCache(Mycelia* application)
+    : application(application)
+{
+    const char* home = getenv("HOME");
+
+    if(home != 0)
+    {
+        directory = string(home) + CACHE_DIRECTORY;
+    }
+
+    snapshot = new Graph(application);
+    storeSnapshot = new Graph(application);
+}
+
+LayoutCache::~LayoutCache()
+{
+    delete snapshot;
+    delete storeSnapshot;
+}
+
+// 64 bit FNV-1a, continued from h
+const CacheKey LayoutCache::hash(const void* data, int size, CacheKey h)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+
+    for(int i = 0; i < size; i++)
+    {
+        h ^= bytes[i];
+        h *= 1099511628211ULL;
+    }
+
+    return h;
+}
+
+const CacheKey LayoutCache::hash(const string& s, CacheKey h)
+{
+    return hash(s.data(), s.size(), h);
+}
+
+const string LayoutCache::getPath(CacheKey key) const
+{
+    char name[32];
+    sprintf(name, "/%016llx.cache", key);
+    return directory + name;
+}
+
+// Snapshots the graph into copy and derives the node identities, the
+// topology key naming the entry and the key of the source file's pointer
+// to it.
+void LayoutCache::getKeys(Graph* copy, const string& source, const vector<double>& parameters,
+                          vector<CacheKey>& identities, CacheKey& topology, CacheKey& pointer)
+{
+    // copy-on-write snapshot, the graph may change while we work
+    application->g->lock();
+    *copy = *application->g;
+    application->g->unlock();
+
+    const vector<int>& nodes = copy->getNodes();
+    vector<int> index(copy->getNodeCapacity(), -1);
+    CacheKey basis = 14695981039346656037ULL;
+    int version = CACHE_VERSION;
+
+    CacheKey settings = hash(&version, sizeof(version), basis);
+
+    if(!parameters.empty())
+    {
+        settings = hash(&parameters[0], parameters.size() * sizeof(double), settings);
+    }
+
+    identities.clear();
+    topology = settings;
+
+    for(int i = 0; i < (int)nodes.size(); i++)
+    {
+        const string& label = copy->getNodeLabel(nodes[i]);
+        CacheKey identity = label.empty() ? hash(&i, sizeof(i), basis) : hash(label, basis);
+
+        index[nodes[i]] = i;
+        identities.push_back(identity);
+        topology = hash(&identity, sizeof(identity), topology);
+    }
+
+    foreach(int edge, copy->getEdges())
+    {
+        const Edge& e = copy->getEdge(edge);
+        int ends[2] = { index[e.source], index[e.target] };
+        topology = hash(ends, sizeof(ends), topology);
+    }
+
+    pointer = hash(source, settings);
+}
+
+const bool LayoutCache::read(CacheKey key, vector<CacheKey>& identities, vector<Vrui::Point>& positions) const
+{
+    ifstream in(getPath(key).c_str(), ios::binary);
+    char magic[4];
+    int version = 0;
+    int count = 0;
+
+    in.read(magic, 4);
+    in.read((char*)&version, sizeof(version));
+    in.read((char*)&count, sizeof(count));
+
+    if(!in || strncmp(magic, "MYCL", 4) != 0 || version != CACHE_VERSION || count < 0)
+    {
+        return false;
+    }
+
+    // recently used, kept by prune
+    utime(getPath(key).c_str(), 0);
+
+    identities.resize(count);
+    positions.resize(count);
+
+    for(int i = 0; i < count; i++)
+    {
+        float p[3];
+        in.read((char*)&identities[i], sizeof(CacheKey));
+        in.read((char*)p, sizeof(p));
+        positions[i] = Vrui::Point(p[0], p[1], p[2]);
+    }
+
+    return (bool)in;
+}
+
+// Writes the copy's positions as an entry. The file is written aside
+// and renamed into place, so a reader never sees half an entry.
+const bool LayoutCache::writeEntry(Graph* copy, const string& path, const vector<CacheKey>& identities) const
+{
+    string temp = path + ".tmp";
+    ofstream out(temp.c_str(), ios::binary);
+    int version = CACHE_VERSION;
+    int count = identities.size();
+
+    out.write("MYCL", 4);
+    out.write((const char*)&version, sizeof(version));
+    out.write((const char*)&count, sizeof(count));
+
+    const vector<int>& nodes = copy->getNodes();
+
+    for(int i = 0; i < count; i++)
+    {
+        const Vrui::Point& position = copy->getNodePosition(nodes[i]);
+        float p[3] = { (float)position[0], (float)position[1], (float)position[2] };
+        out.write((const char*)&identities[i], sizeof(CacheKey));
+        out.write((const char*)p, sizeof(p));
+    }
+
+    out.close();
+
+    if(!out || rename(temp.c_str(), path.c_str()) != 0)
+    {
+        cout << "could not write " << path << endl;
+        remove(temp.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+// Entry for the current graph at any path, for copying layouts around.
+const bool LayoutCache::write(const string& path)
+{
+    vector<CacheKey> identities;
+    CacheKey topology;
+    CacheKey pointer;
+    getKeys(snapshot, "", vector<double>(), identities, topology, pointer);
+
+    return writeEntry(snapshot, path, identities);
+}
+
+// Keeps the current positions under the graph's key.
+void LayoutCache::store(const string& source, const vector<double>& parameters)
+{
+    if(directory.empty()) return;
+
+    vector<CacheKey> identities;
+    CacheKey topology;
+    CacheKey pointer;
+
+    storeMutex.lock();
+
+    getKeys(storeSnapshot, source, parameters, identities, topology, pointer);
+
+    if(!identities.empty())
+    {
+        mkdir(directory.substr(0, directory.rfind('/')).c_str(), 0755);
+        mkdir(directory.c_str(), 0755);
+
+        if(writeEntry(storeSnapshot, getPath(topology), identities))
+        {
+            writePointer(pointer, topology);
+            prune();
+        }
+    }
+
+    storeMutex.unlock();
+}
+
+// Removes the least recently used entries and pointers beyond
+// CACHE_MAX_FILES. A pointer left without its entry is just a miss.
+void LayoutCache::prune() const
+{
+    DIR* dir = opendir(directory.c_str());
+
+    if(dir == 0) return;
+
+    vector<pair<time_t, string> > files;
+    struct dirent* entry;
+
+    while((entry = readdir(dir)) != 0)
+    {
+        string name(entry->d_name);
+        string path = directory + "/" + name;
+        struct stat info;
+
+        if(name.size() > 6 && name.compare(name.size() - 6, 6, ".cache") == 0 && stat(path.c_str(), &info) == 0)
+        {
+            files.push_back(make_pair(info.st_mtime, path));
+        }
+    }
+
+    closedir(dir);
+
+    if((int)files.size() <= CACHE_MAX_FILES) return;
+
+    sort(files.begin(), files.end());
+
+    for(int i = 0; i < (int)files.size() - CACHE_MAX_FILES; i++)
+    {
+        remove(files[i].second.c_str());
+    }
+}
+
+// The source file's pointer to its newest entry.
+void LayoutCache::writePointer(CacheKey pointer, CacheKey topology) const
+{
+    string pointerPath = getPath(pointer);
+    string temp = pointerPath + ".tmp";
+    ofstream link(temp.c_str(), ios::binary);
+
+    link.write("MYCP", 4);
+    link.write((const char*)&topology, sizeof(topology));
+    link.close();
+
+    if(!link || rename(temp.c_str(), pointerPath.c_str()) != 0)
+    {
+        remove(temp.c_str());
+    }
+}
+
+// Sets the graph's positions from the cache. A near hit places the nodes
+// not found at the barycenter of their found neighbors, or near the middle
+// of the graph if they have none.
+const int LayoutCache::restore(const string& source, const vector<double>& parameters)
+{
+    if(directory.empty()) return CACHE_MISS;
+
+    vector<CacheKey> identities;
+    CacheKey topology;
+    CacheKey pointer;
+    getKeys(snapshot, source, parameters, identities, topology, pointer);
+
+    vector<int> nodes = snapshot->getNodes();
+    int size = nodes.size();
+
+    if(size == 0) return CACHE_MISS;
+
+    vector<CacheKey> cachedIdentities;
+    vector<Vrui::Point> cachedPositions;
+
+    if(read(topology, cachedIdentities, cachedPositions) && (int)cachedPositions.size() == size)
+    {
+        application->g->setNodePositions(nodes, cachedPositions);
+        return CACHE_HIT;
+    }
+
+    // the entry last written for this source, if any
+    ifstream in(getPath(pointer).c_str(), ios::binary);
+    char magic[4];
+    CacheKey key = 0;
+
+    in.read(magic, 4);
+    in.read((char*)&key, sizeof(key));
+
+    if(!in || strncmp(magic, "MYCP", 4) != 0 || !read(key, cachedIdentities, cachedPositions))
+    {
+        return CACHE_MISS;
+    }
+
+    utime(getPath(pointer).c_str(), 0);
+
+    map<CacheKey, Vrui::Point> cached;
+
+    for(int i = 0; i < (int)cachedIdentities.size(); i++)
+    {
+        cached.insert(make_pair(cachedIdentities[i], cachedPositions[i]));
+    }
+
+    vector<Vrui::Point> positions(size, Vrui::Point(0, 0, 0));
+    vector<int> found(snapshot->getNodeCapacity(), -1); // row of each found node
+    Vrui::Vector center(0, 0, 0);
+    int matched = 0;
+
+    for(int i = 0; i < size; i++)
+    {
+        map<CacheKey, Vrui::Point>::const_iterator it = cached.find(identities[i]);
+
+        if(it != cached.end())
+        {
+            positions[i] = it->second;
+            found[nodes[i]] = i;
+            center += it->second - Vrui::Point::origin;
+            matched++;
+        }
+    }
+
+    if(matched < CACHE_NEAR_FRACTION * size)
+    {
+        return CACHE_MISS;
+    }
+
+    center /= Vrui::Scalar(matched);
+
+    for(int i = 0; i < size; i++)
+    {
+        if(found[nodes[i]] != -1) continue;
+
+        vector<int> neighbors;
+
+        foreach(int edge, snapshot->getOutEdges(nodes[i]))
+        {
+            neighbors.push_back(snapshot->getEdge(edge).target);
+        }
+
+        foreach(int edge, snapshot->getInEdges(nodes[i]))
+        {
+            neighbors.push_back(snapshot->getEdge(edge).source);
+        }
+
+        Vrui::Vector sum(0, 0, 0);
+        int count = 0;
+
+        foreach(int neighbor, neighbors)
+        {
+            if(found[neighbor] != -1)
+            {
+                sum += positions[found[neighbor]] - Vrui::Point::origin;
+                count++;
+            }
+        }
+
+        Vrui::Vector base = count > 0 ? sum / Vrui::Scalar(count) : center;
+        positions[i] = Vrui::Point(base[0] + PLACEMENT_OFFSET * (2 * VruiHelp::randomFloat() - 1),
+                                   base[1] + PLACEMENT_OFFSET * (2 * VruiHelp::randomFloat() - 1),
+                                   base[2] + PLACEMENT_OFFSET * (2 * VruiHelp::randomFloat() - 1) );
+    }
+
+    application->g->setNodePositions(nodes, positions);
+
+    return CACHE_NEAR_HIT;
+}
\ No newline at end of file
@@ -0,0 +1,82 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LAYOUTCACHE_HPP
+#define __LAYOUTCACHE_HPP
+
+#include <graph.hpp>
+#include <mycelia.hpp>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+
+#define CACHE_MISS 0
+#define CACHE_HIT 1
+#define CACHE_NEAR_HIT 2
+#define CACHE_VERSION 1 // bump when layouts change what they produce
+#define CACHE_NEAR_FRACTION 0.9 // nodes that must be found for a near hit
+#define CACHE_DIRECTORY "/.mycelia/layouts" // under $HOME
+#define CACHE_MAX_FILES 512 // least recently used files beyond this are removed
+
+typedef unsigned long long CacheKey;
+
+/*
+ * On-disk cache of finished layouts. An entry holds, for every node in list
+ * order, an identity (a hash of its label, or of its position in the list
+ * for unlabeled nodes) and its position. Entries are named by a hash of the
+ * topology together with the layout type and parameters, so a hit restores
+ * the exact same graph. A second, smaller file per source file and
+ * parameter set names the last entry written for it; if the topology has
+ * changed only a little since, its nodes are matched by identity and the
+ * layout warm starts from them. Reading a file touches it, and stores
+ * remove the least recently used files beyond CACHE_MAX_FILES.
+ *
+ * Layout threads store while the main thread restores, so stores take a
+ * snapshot of their own and are serialized among themselves.
+ */
+class LayoutCache
+{
+private:
+    Mycelia* application;
+    Graph* snapshot;
+    Graph* storeSnapshot;
+    Threads::Mutex storeMutex;
+    std::string directory;
+
+    static const CacheKey hash(const void*, int, CacheKey);
+    static const CacheKey hash(const std::string&, CacheKey);
+
+    const std::string getPath(CacheKey) const;
+    void prune() const;
+    void getKeys(Graph*, const std::string&, const std::vector<double>&, std::vector<CacheKey>&,
+                 CacheKey&, CacheKey&);
+    const bool read(CacheKey, std::vector<CacheKey>&, std::vector<Vrui::Point>&) const;
+    const bool writeEntry(Graph*, const std::string&, const std::vector<CacheKey>&) const;
+    void writePointer(CacheKey, CacheKey) const;
+
+public:
+    LayoutCache(Mycelia*);
+    ~LayoutCache();
+
+    const int restore(const std::string&, const std::vector<double>&);
+    void store(const std::string&, const std::vector<double>&);
+    const bool write(const std::string&);
+};
+
+#endif
@@ -0,0 +1,431 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <layout/multilevellayout.hpp>
+
+using namespace std;
+
+MultilevelLayout::MultilevelLayout(Mycelia* application)
+    : GraphLayout(application),
+      theta(THETA)
+{
+    snapshot = new Graph(application);
+}
+
+MultilevelLayout::~MultilevelLayout()
+{
+    stop();
+    delete snapshot;
+}
+
+// FR forces on a range of nodes of one level. Like FruchtermanReingoldStep
+// each node gathers onto itself only, so the split across threads does not
+// change the result.
+class MultilevelStep : public ThreadPool::Task
+{
+private:
+    const MultilevelLayout::Level& level;
+    const Octree& octree;
+    double springForceConstant;
+    double theta;
+    double temperature;
+    
+public:
+    vector<Vrui::Vector>& displacements;
+    
+    MultilevelStep(const MultilevelLayout::Level& level, const Octree& octree, double springForceConstant,
+                   double theta, double temperature, vector<Vrui::Vector>& displacements)
+        : level(level),
+          octree(octree),
+          springForceConstant(springForceConstant),
+          theta(theta),
+          temperature(temperature),
+          displacements(displacements)
+    {
+    }
+    
+    void run(int chunk, int begin, int end)
+    {
+        const vector<Vrui::Point>& positions = level.positions;
+        
+        for(int node = begin; node < end; node++)
+        {
+            FruchtermanReingoldRepulsion repulsion(positions, level.degrees, springForceConstant, node);
+            octree.traverse(positions[node], theta, repulsion);
+            Vrui::Vector force = repulsion.total;
+            
+            // attract neighbors as distance^2 / k
+            for(int i = level.offsets[node]; i < level.offsets[node + 1]; i++)
+            {
+                Vrui::Vector v = positions[node] - positions[level.targets[i]];
+                Vrui::Scalar mag = Geometry::mag(v);
+                
+                if(mag > 0) v = v.normalize();
+                
+                force -= v * (mag * mag / springForceConstant * level.weights[i]);
+            }
+            
+            Vrui::Scalar mag = force.mag();
+            
+            if(mag > temperature)
+            {
+                force *= temperature / mag;
+            }
+            
+            displacements[node] = force;
+        }
+    }
+};
+
+// Small fixed offset per node, separates children placed on their parent.
+static Vrui::Vector jitter(int node, Vrui::Scalar radius)
+{
+    unsigned int h = node * 2654435761u + 1;
+    Vrui::Vector v;
+    
+    for(int i = 0; i < 3; i++)
+    {
+        h ^= h >> 15;
+        h *= 2246822519u;
+        h ^= h >> 13;
+        v[i] = ((h & 0xffff) / 65535.0 * 2 - 1) * radius;
+    }
+    
+    return v;
+}
+
+double MultilevelLayout::getSpringLength(int nodeCount)
+{
+    return Math::pow(VOLUME / (double)nodeCount, 1.0 / 3.0);
+}
+
+void* MultilevelLayout::layout()
+{
+    buildFinest();
+    
+    if(levels[0].size() == 0)
+    {
+        levels.clear();
+        stopped = true;
+        return 0;
+    }
+    
+    while(!stopped && levels.back().size() > COARSEST_SIZE && coarsen());
+    
+    // full schedule on the coarsest level, short cool runs on the others
+    int coarsest = levels.size() - 1;
+    refine(coarsest, MAX_ITERATIONS, MAX_DELTA);
+    publish(coarsest);
+    
+    for(int level = coarsest - 1; level >= 0 && !stopped; level--)
+    {
+        prolong(level);
+        refine(level, LEVEL_ITERATIONS, LEVEL_TEMPERATURE * getSpringLength(levels[level].size()));
+        publish(level);
+    }
+    
+    levels.clear();
+    nodes.clear();
+    
+    // only complete runs are worth keeping
+    if(!stopped)
+    {
+        application->layoutFinished();
+    }
+    
+    stopped = true;
+    application->resetNavigationCallback(0);
+    
+    return 0;
+}
+
+// Appends one node's neighbors to the level, merging parallel edges.
+void MultilevelLayout::addNeighbors(Level& level, vector<pair<int, Vrui::Scalar> >& neighbors)
+{
+    sort(neighbors.begin(), neighbors.end());
+    
+    Vrui::Scalar degree = 0;
+    
+    for(int i = 0; i < (int)neighbors.size(); i++)
+    {
+        if(i > 0 && neighbors[i].first == neighbors[i - 1].first)
+        {
+            level.weights.back() += neighbors[i].second;
+        }
+        else
+        {
+            level.targets.push_back(neighbors[i].first);
+            level.weights.push_back(neighbors[i].second);
+        }
+        
+        degree += neighbors[i].second;
+    }
+    
+    level.offsets.push_back(level.targets.size());
+    level.degrees.push_back(degree);
+}
+
+void MultilevelLayout::buildFinest()
+{
+    // copy-on-write snapshot, the graph may change while we work
+    application->g->lock();
+    *snapshot = *application->g;
+    application->g->unlock();
+    
+    levels.assign(1, Level());
+    nodes.clear();
+    
+    Level& level = levels[0];
+    vector<int> index(snapshot->getNodeCapacity(), -1);
+    
+    foreach(int node, snapshot->getNodes())
+    {
+        if(application->isSelectedComponent(node))
+        {
+            index[node] = nodes.size();
+            nodes.push_back(node);
+            level.positions.push_back(snapshot->getNodePosition(node));
+            level.masses.push_back(1);
+        }
+    }
+    
+    // undirected, without self loops
+    vector<pair<int, Vrui::Scalar> > neighbors;
+    level.offsets.push_back(0);
+    
+    foreach(int node, nodes)
+    {
+        neighbors.clear();
+        
+        foreach(int edge, snapshot->getOutEdges(node))
+        {
+            const Edge& e = snapshot->getEdge(edge);
+            
+            if(e.target != node && index[e.target] != -1)
+            {
+                neighbors.push_back(make_pair(index[e.target], (Vrui::Scalar)e.weight));
+            }
+        }
+        
+        foreach(int edge, snapshot->getInEdges(node))
+        {
+            const Edge& e = snapshot->getEdge(edge);
+            
+            if(e.source != node && index[e.source] != -1)
+            {
+                neighbors.push_back(make_pair(index[e.source], (Vrui::Scalar)e.weight));
+            }
+        }
+        
+        addNeighbors(level, neighbors);
+    }
+}
+
+// Adds the next coarser level. Returns false, and adds nothing, once
+// matching no longer shrinks the graph enough to be worth a level.
+const bool MultilevelLayout::coarsen()
+{
+    levels.push_back(Level());
+    
+    Level& fine = levels[levels.size() - 2];
+    Level& coarse = levels.back();
+    int n = fine.size();
+    
+    fine.parents.assign(n, -1);
+    
+    // heavy edge matching, light nodes first to keep merged nodes balanced
+    vector<pair<Vrui::Scalar, int> > order(n);
+    
+    for(int node = 0; node < n; node++)
+    {
+        order[node] = make_pair(fine.masses[node], node);
+    }
+    
+    sort(order.begin(), order.end());
+    
+    for(int i = 0; i < n; i++)
+    {
+        int node = order[i].second;
+        int match = -1;
+        
+        if(fine.parents[node] != -1) continue;
+        
+        for(int j = fine.offsets[node]; j < fine.offsets[node + 1]; j++)
+        {
+            int other = fine.targets[j];
+            
+            if(fine.parents[other] != -1) continue;
+            
+            if(match == -1
+               || fine.weights[j] > fine.weights[match]
+               || (fine.weights[j] == fine.weights[match] && fine.masses[other] < fine.masses[fine.targets[match]]))
+            {
+                match = j;
+            }
+        }
+        
+        if(match == -1) continue;
+        
+        int other = fine.targets[match];
+        fine.parents[node] = fine.parents[other] = coarse.size();
+        coarse.positions.push_back(fine.positions[node]);
+        coarse.masses.push_back(fine.masses[node] + fine.masses[other]);
+    }
+    
+    // Leaves whose neighbor was taken join it. Matching alone stalls on
+    // stars and trees, where most leaves share a hub.
+    for(int node = 0; node < n; node++)
+    {
+        if(fine.parents[node] != -1 || fine.offsets[node + 1] - fine.offsets[node] != 1) continue;
+        
+        int parent = fine.parents[fine.targets[fine.offsets[node]]];
+        
+        if(parent != -1)
+        {
+            fine.parents[node] = parent;
+            coarse.masses[parent] += fine.masses[node];
+        }
+    }
+    
+    // everything else carries over alone
+    for(int node = 0; node < n; node++)
+    {
+        if(fine.parents[node] != -1) continue;
+        
+        fine.parents[node] = coarse.size();
+        coarse.positions.push_back(fine.positions[node]);
+        coarse.masses.push_back(fine.masses[node]);
+    }
+    
+    if(coarse.size() > COARSEN_RATIO * n)
+    {
+        fine.parents.clear();
+        levels.pop_back();
+        return false;
+    }
+    
+    // group fine nodes by parent, counting sort
+    vector<int> childOffsets(coarse.size() + 1, 0);
+    vector<int> children(n);
+    
+    for(int node = 0; node < n; node++)
+    {
+        childOffsets[fine.parents[node] + 1]++;
+    }
+    
+    for(int parent = 0; parent < coarse.size(); parent++)
+    {
+        childOffsets[parent + 1] += childOffsets[parent];
+    }
+    
+    vector<int> cursor(childOffsets.begin(), childOffsets.end() - 1);
+    
+    for(int node = 0; node < n; node++)
+    {
+        children[cursor[fine.parents[node]]++] = node;
+    }
+    
+    // edges between groups, summed
+    vector<pair<int, Vrui::Scalar> > neighbors;
+    coarse.offsets.push_back(0);
+    
+    for(int parent = 0; parent < coarse.size(); parent++)
+    {
+        neighbors.clear();
+        
+        for(int i = childOffsets[parent]; i < childOffsets[parent + 1]; i++)
+        {
+            int node = children[i];
+            
+            for(int j = fine.offsets[node]; j < fine.offsets[node + 1]; j++)
+            {
+                int other = fine.parents[fine.targets[j]];
+                
+                if(other != parent)
+                {
+                    neighbors.push_back(make_pair(other, fine.weights[j]));
+                }
+            }
+        }
+        
+        addNeighbors(coarse, neighbors);
+    }
+    
+    return true;
+}
+
+// Places each node of a level on its parent, slightly apart from siblings.
+void MultilevelLayout::prolong(int index)
+{
+    Level& fine = levels[index];
+    const Level& coarse = levels[index + 1];
+    Vrui::Scalar radius = 0.1 * getSpringLength(fine.size());
+    
+    for(int node = 0; node < fine.size(); node++)
+    {
+        fine.positions[node] = coarse.positions[fine.parents[node]] + jitter(node, radius);
+    }
+}
+
+void MultilevelLayout::refine(int index, int iterations, double maxTemperature)
+{
+    Level& level = levels[index];
+    double springForceConstant = getSpringLength(level.size());
+    vector<Vrui::Vector> displacements(level.size());
+    vector<int> ids(level.size());
+    
+    for(int node = 0; node < level.size(); node++)
+    {
+        ids[node] = node;
+    }
+    
+    for(int remaining = iterations; remaining > 0 && !stopped; remaining--)
+    {
+        double temperature = maxTemperature * Math::pow(remaining / (double)iterations, COOLING_EXPONENT);
+        
+        octree.build(level.positions, ids, level.degrees);
+        
+        MultilevelStep step(level, octree, springForceConstant, theta, temperature, displacements);
+        application->threadPool->parallelFor(level.size(), LAYOUT_GRAIN, step);
+        
+        for(int node = 0; node < level.size(); node++)
+        {
+            level.positions[node] += displacements[node];
+        }
+    }
+}
+
+// Sends a level's positions to the graph, each node at its ancestor's.
+void MultilevelLayout::publish(int index)
+{
+    vector<Vrui::Point> positions(nodes.size());
+    
+    for(int i = 0; i < (int)nodes.size(); i++)
+    {
+        int node = i;
+        
+        for(int level = 0; level < index; level++)
+        {
+            node = levels[level].parents[node];
+        }
+        
+        positions[i] = levels[index].positions[node];
+    }
+    
+    application->g->setLayoutPositions(nodes, positions);
+}
\ No newline at end of file
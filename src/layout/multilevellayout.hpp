@@ -0,0 +1,90 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MULTILEVELLAYOUT_HPP
+#define __MULTILEVELLAYOUT_HPP
+
+#include <graph.hpp>
+#include <mycelia.hpp>
+#include <threadpool.hpp>
+#include <layout/frlayout.hpp>
+#include <layout/graphlayout.hpp>
+#include <layout/octree.hpp>
+
+#define COARSEST_SIZE 50 // stop coarsening at this many nodes
+#define COARSEN_RATIO 0.9 // or when a level keeps more than this fraction
+#define LEVEL_ITERATIONS 30 // refinement steps per level
+#define LEVEL_TEMPERATURE 2 // initial refinement step, in spring lengths
+
+/*
+ * Multilevel layout in the style of Walshaw. The selected component is
+ * coarsened by heavy edge matching, with leaves folded into their only
+ * neighbor, until it is small. The coarsest graph gets a full
+ * Fruchterman-Reingold layout; each finer level then starts from its
+ * parent's position and is refined with a short, cool FR run. Every level
+ * uses the Barnes-Hut octree, so the total is close to linear for sparse
+ * graphs.
+ */
+class MultilevelLayout : public GraphLayout
+{
+    friend class MultilevelStep;
+
+private:
+    // one level of the hierarchy, nodes numbered from 0
+    struct Level
+    {
+        std::vector<int> offsets; // CSR, both directions of every edge
+        std::vector<int> targets;
+        std::vector<Vrui::Scalar> weights;
+        std::vector<Vrui::Scalar> degrees; // summed edge weight
+        std::vector<Vrui::Scalar> masses; // level 0 nodes merged into each
+        std::vector<int> parents; // node in the next coarser level
+        std::vector<Vrui::Point> positions;
+
+        const int size() const { return positions.size(); }
+    };
+
+    std::vector<Level> levels;
+    std::vector<int> nodes; // graph node of each level 0 node
+    double theta;
+
+    Graph* snapshot;
+    Octree octree;
+
+    static void addNeighbors(Level&, std::vector<std::pair<int, Vrui::Scalar> >&);
+    static double getSpringLength(int);
+
+    void buildFinest();
+    const bool coarsen();
+    void prolong(int);
+    void refine(int, int, double);
+    void publish(int);
+
+public:
+    MultilevelLayout(Mycelia*);
+    ~MultilevelLayout();
+
+    double getTheta() const { return theta; }
+    void setTheta(double t) { theta = t; }
+    virtual void getParameters(std::vector<double>& parameters) const { parameters.push_back(theta); }
+
+protected:
+    virtual void* layout();
+};
+
+#endif
@@ -0,0 +1,146 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <layout/octree.hpp>
+
+using namespace std;
+
+void Octree::build(const vector<Vrui::Point>& positions, const vector<int>& nodes, const vector<Vrui::Scalar>& weights)
+{
+    cells.clear();
+    packed.clear();
+    ids = nodes;
+    scratch.resize(ids.size());
+
+    if(ids.empty()) return;
+
+    // bounding cube
+    Vrui::Point lo = positions[ids[0]];
+    Vrui::Point hi = lo;
+
+    foreach(int id, ids)
+    {
+        for(int i = 0; i < 3; i++)
+        {
+            lo[i] = min(lo[i], positions[id][i]);
+            hi[i] = max(hi[i], positions[id][i]);
+        }
+    }
+
+    Vrui::Scalar halfSize = 0;
+
+    for(int i = 0; i < 3; i++)
+    {
+        halfSize = max(halfSize, (hi[i] - lo[i]) / 2);
+    }
+
+    halfSize = halfSize * 1.001 + 1e-9;
+    cells.reserve(2 * ids.size() / OCTREE_LEAF_SIZE + 1);
+    buildCell(positions, weights, Geometry::mid(lo, hi), halfSize, 0, ids.size(), 0);
+
+    foreach(int id, ids)
+    {
+        packed.push_back(positions[id], weights.empty() ? 1 : weights[id]);
+    }
+}
+
+int Octree::buildCell(const vector<Vrui::Point>& positions, const vector<Vrui::Scalar>& weights,
+                      const Vrui::Point& boxCenter, Vrui::Scalar halfSize, int begin, int end, int depth)
+{
+    int index = cells.size();
+    cells.push_back(Cell());
+
+    Cell& c = cells[index];
+    c.boxCenter = boxCenter;
+    c.halfSize = halfSize;
+    c.begin = begin;
+    c.end = end;
+    c.leaf = end - begin <= OCTREE_LEAF_SIZE || depth >= OCTREE_MAX_DEPTH;
+
+    // centers of mass
+    Vrui::Vector sum(0, 0, 0);
+    Vrui::Vector weightedSum(0, 0, 0);
+    Vrui::Scalar weight = 0;
+
+    for(int i = begin; i < end; i++)
+    {
+        Vrui::Scalar w = weights.empty() ? 1 : weights[ids[i]];
+        Vrui::Vector p = positions[ids[i]] - Vrui::Point::origin;
+        sum += p;
+        weightedSum += p * w;
+        weight += w;
+    }
+
+    c.mass = end - begin;
+    c.center = Vrui::Point::origin + sum / c.mass;
+    c.weight = weight;
+    c.weightedCenter = weight != 0 ? Vrui::Point::origin + weightedSum / weight : c.center;
+
+    for(int k = 0; k < 8; k++)
+    {
+        c.children[k] = -1;
+    }
+
+    if(c.leaf) return index;
+
+    // partition ids by octant, counting sort through scratch
+    int counts[8] = {0};
+    int offsets[9];
+
+    for(int i = begin; i < end; i++)
+    {
+        const Vrui::Point& p = positions[ids[i]];
+        scratch[i] = (p[0] > boxCenter[0]) | (p[1] > boxCenter[1]) << 1 | (p[2] > boxCenter[2]) << 2;
+        counts[scratch[i]]++;
+    }
+
+    offsets[0] = begin;
+
+    for(int k = 0; k < 8; k++)
+    {
+        offsets[k + 1] = offsets[k] + counts[k];
+    }
+
+    vector<int> sorted(end - begin);
+    int cursor[8];
+    copy(offsets, offsets + 8, cursor);
+
+    for(int i = begin; i < end; i++)
+    {
+        sorted[cursor[scratch[i]]++ - begin] = ids[i];
+    }
+
+    copy(sorted.begin(), sorted.end(), ids.begin() + begin);
+
+    // recurse, cells may reallocate so c is not used past this point
+    Vrui::Scalar h = halfSize / 2;
+
+    for(int k = 0; k < 8; k++)
+    {
+        if(counts[k] == 0) continue;
+
+        Vrui::Point childCenter(boxCenter[0] + (k & 1 ? h : -h),
+                                boxCenter[1] + (k & 2 ? h : -h),
+                                boxCenter[2] + (k & 4 ? h : -h));
+
+        int child = buildCell(positions, weights, childCenter, h, offsets[k], offsets[k + 1], depth + 1);
+        cells[index].children[k] = child;
+    }
+
+    return index;
+}
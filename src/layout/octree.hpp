@@ -0,0 +1,121 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __OCTREE_HPP
+#define __OCTREE_HPP
+
+#include <mycelia.hpp>
+#include <layout/forcekernel.hpp>
+
+#define OCTREE_LEAF_SIZE 8
+#define OCTREE_MAX_DEPTH 24
+
+/*
+ * Barnes-Hut octree over a subset of node positions. Each cell keeps two
+ * centers of mass: one where every point counts once, and one weighted by a
+ * per-point weight (node degree for FR). Far cells stand in for their
+ * points during traversal.
+ */
+class Octree
+{
+public:
+    struct Cell
+    {
+        Vrui::Point boxCenter;
+        Vrui::Scalar halfSize;
+
+        Vrui::Point center; // every point counts once
+        Vrui::Scalar mass; // number of points
+        Vrui::Point weightedCenter;
+        Vrui::Scalar weight; // sum of point weights
+
+        int children[8]; // -1 if empty
+        int begin; // range of ids covered by this cell
+        int end;
+        bool leaf;
+
+        const bool contains(const Vrui::Point& p) const
+        {
+            return Math::abs(p[0] - boxCenter[0]) <= halfSize
+                && Math::abs(p[1] - boxCenter[1]) <= halfSize
+                && Math::abs(p[2] - boxCenter[2]) <= halfSize;
+        }
+    };
+
+private:
+    std::vector<Cell> cells;
+    std::vector<int> ids; // point ids, contiguous per cell
+    std::vector<int> scratch;
+    PackedPoints packed; // positions and weights in ids order
+
+    int buildCell(const std::vector<Vrui::Point>&, const std::vector<Vrui::Scalar>&,
+                  const Vrui::Point&, Vrui::Scalar, int, int, int);
+
+public:
+    // positions and weights are indexed by id, empty weights count as 1
+    void build(const std::vector<Vrui::Point>&, const std::vector<int>&, const std::vector<Vrui::Scalar>&);
+
+    const std::vector<Cell>& getCells() const { return cells; }
+
+    /*
+     * Calls visitor.cell(cell) for cells far enough from p to be
+     * approximated (size / distance < theta, p outside the cell) and
+     * visitor.points(packed, begin, end) for the points of the leaves that
+     * are not. The point at p itself is passed like any other. A theta of
+     * 0 is exact and hands every point over in a single run.
+     */
+    template <class Visitor>
+    void traverse(const Vrui::Point& p, Vrui::Scalar theta, Visitor& visitor) const
+    {
+        if(cells.empty()) return;
+
+        if(theta <= 0)
+        {
+            visitor.points(packed, 0, packed.size());
+            return;
+        }
+
+        int stack[7 * OCTREE_MAX_DEPTH + 8];
+        int top = 0;
+        stack[top++] = 0;
+
+        while(top > 0)
+        {
+            const Cell& c = cells[stack[--top]];
+
+            if(c.leaf)
+            {
+                visitor.points(packed, c.begin, c.end);
+                continue;
+            }
+
+            if(2 * c.halfSize < theta * Geometry::mag(p - c.center) && !c.contains(p))
+            {
+                visitor.cell(c);
+                continue;
+            }
+
+            for(int k = 0; k < 8; k++)
+            {
+                if(c.children[k] != -1) stack[top++] = c.children[k];
+            }
+        }
+    }
+};
+
+#endif
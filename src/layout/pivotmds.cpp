@@ -0,0 +1,440 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <layout/pivotmds.hpp>
+
+using namespace std;
+
+PivotMds::PivotMds(Mycelia* application)
+    : application(application),
+      size(0),
+      pivotCount(0)
+{
+    snapshot = new Graph(application);
+}
+
+PivotMds::~PivotMds()
+{
+    delete snapshot;
+}
+
+// Hop distance from one row to every other, -1 where unreachable. Edges
+// count in both directions.
+void PivotMds::search(int source, vector<int>& distances)
+{
+    distances.assign(size, -1);
+    vector<int> queue;
+    queue.reserve(size);
+
+    distances[source] = 0;
+    queue.push_back(source);
+
+    for(int head = 0; head < (int)queue.size(); head++)
+    {
+        int row = queue[head];
+        int node = nodes[row];
+
+        foreach(int edge, snapshot->getOutEdges(node))
+        {
+            int next = index[snapshot->getEdge(edge).target];
+
+            if(distances[next] == -1)
+            {
+                distances[next] = distances[row] + 1;
+                queue.push_back(next);
+            }
+        }
+
+        foreach(int edge, snapshot->getInEdges(node))
+        {
+            int next = index[snapshot->getEdge(edge).source];
+
+            if(distances[next] == -1)
+            {
+                distances[next] = distances[row] + 1;
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+// Max-min pivot selection starting from the highest degree node. Fills one
+// column of squared distances per pivot and returns the number of pivots,
+// which is smaller than PIVOT_COUNT only for tiny graphs.
+const int PivotMds::choosePivots()
+{
+    int pivot = 0;
+
+    for(int row = 1; row < size; row++)
+    {
+        if(snapshot->getNodeDegree(nodes[row]) > snapshot->getNodeDegree(nodes[pivot])) pivot = row;
+    }
+
+    int count = min(PIVOT_COUNT, size);
+    columns.assign((size_t)count * size, 0);
+    vector<int> nearest(size, INT_MAX);
+    vector<int> distances;
+
+    for(int p = 0; p < count; p++)
+    {
+        search(pivot, distances);
+
+        int farthest = 0;
+
+        foreach(int d, distances)
+        {
+            farthest = max(farthest, d);
+        }
+
+        float* column = &columns[(size_t)p * size];
+
+        for(int row = 0; row < size; row++)
+        {
+            int d = distances[row] == -1 ? farthest + 1 : distances[row];
+            column[row] = (float)d * d;
+            nearest[row] = min(nearest[row], d);
+        }
+
+        // the next pivot is the node farthest from all chosen so far
+        int next = pivot;
+
+        for(int row = 0; row < size; row++)
+        {
+            if(nearest[row] > nearest[next]) next = row;
+        }
+
+        // every node is a pivot
+        if(nearest[next] == 0)
+        {
+            return p + 1;
+        }
+
+        pivot = next;
+    }
+
+    return count;
+}
+
+// Double centering, b = -(d^2 - row mean - column mean + grand mean) / 2.
+// Each row only touches its own entries.
+class PivotCenter : public ThreadPool::Task
+{
+private:
+    PivotMds* mds;
+    const vector<double>& columnMeans;
+    double grandMean;
+
+public:
+    PivotCenter(PivotMds* mds, const vector<double>& columnMeans, double grandMean)
+        : mds(mds),
+          columnMeans(columnMeans),
+          grandMean(grandMean)
+    {
+    }
+
+    void run(int chunk, int begin, int end)
+    {
+        int size = mds->size;
+        int k = mds->pivotCount;
+        float* columns = &mds->columns[0];
+
+        for(int row = begin; row < end; row++)
+        {
+            double rowMean = 0;
+
+            for(int p = 0; p < k; p++)
+            {
+                rowMean += columns[(size_t)p * size + row];
+            }
+
+            rowMean /= k;
+
+            for(int p = 0; p < k; p++)
+            {
+                float& b = columns[(size_t)p * size + row];
+                b = -0.5 * (b - rowMean - columnMeans[p] + grandMean);
+            }
+        }
+    }
+};
+
+void PivotMds::center()
+{
+    vector<double> columnMeans(pivotCount, 0);
+    double grandMean = 0;
+
+    for(int p = 0; p < pivotCount; p++)
+    {
+        const float* column = &columns[(size_t)p * size];
+
+        for(int row = 0; row < size; row++)
+        {
+            columnMeans[p] += column[row];
+        }
+
+        columnMeans[p] /= size;
+        grandMean += columnMeans[p];
+    }
+
+    grandMean /= pivotCount;
+
+    PivotCenter task(this, columnMeans, grandMean);
+    application->threadPool->parallelFor(size, PIVOT_GRAIN, task);
+}
+
+// Upper triangle of B^T B, one partial sum per chunk so the chunks can be
+// added in order afterwards.
+class PivotGram : public ThreadPool::Task
+{
+private:
+    PivotMds* mds;
+
+public:
+    vector<vector<double> > partials;
+
+    PivotGram(PivotMds* mds, int chunks)
+        : mds(mds),
+          partials(chunks, vector<double>(mds->pivotCount * mds->pivotCount, 0))
+    {
+    }
+
+    void run(int chunk, int begin, int end)
+    {
+        int size = mds->size;
+        int k = mds->pivotCount;
+        const float* columns = &mds->columns[0];
+        vector<double>& gram = partials[chunk];
+
+        for(int p = 0; p < k; p++)
+        {
+            const float* a = columns + (size_t)p * size;
+
+            for(int q = p; q < k; q++)
+            {
+                const float* b = columns + (size_t)q * size;
+                float sum = 0;
+
+                for(int row = begin; row < end; row++)
+                {
+                    sum += a[row] * b[row];
+                }
+
+                gram[p * k + q] += sum;
+            }
+        }
+    }
+};
+
+// Three leading eigenvectors of B^T B by power iteration, each kept
+// orthogonal to the ones before it.
+const vector<vector<double> > PivotMds::axes()
+{
+    int k = pivotCount;
+    int chunks = application->threadPool->getChunkCount(size, PIVOT_GRAIN);
+    PivotGram task(this, chunks);
+    application->threadPool->parallelFor(size, PIVOT_GRAIN, task);
+
+    vector<double> gram(k * k, 0);
+
+    foreach(const vector<double>& partial, task.partials)
+    {
+        for(int p = 0; p < k; p++)
+        {
+            for(int q = p; q < k; q++)
+            {
+                gram[p * k + q] += partial[p * k + q];
+            }
+        }
+    }
+
+    for(int p = 0; p < k; p++)
+    {
+        for(int q = 0; q < p; q++)
+        {
+            gram[p * k + q] = gram[q * k + p];
+        }
+    }
+
+    vector<vector<double> > vectors;
+
+    for(int axis = 0; axis < 3; axis++)
+    {
+        vector<double> v(k);
+
+        for(int p = 0; p < k; p++)
+        {
+            v[p] = VruiHelp::randomFloat() - 0.5;
+        }
+
+        for(int iteration = 0; iteration < PIVOT_ITERATIONS; iteration++)
+        {
+            vector<double> w(k, 0);
+
+            for(int p = 0; p < k; p++)
+            {
+                for(int q = 0; q < k; q++)
+                {
+                    w[p] += gram[p * k + q] * v[q];
+                }
+            }
+
+            foreach(const vector<double>& u, vectors)
+            {
+                double dot = 0;
+                for(int p = 0; p < k; p++) dot += w[p] * u[p];
+                for(int p = 0; p < k; p++) w[p] -= dot * u[p];
+            }
+
+            double norm = 0;
+            for(int p = 0; p < k; p++) norm += w[p] * w[p];
+            norm = sqrt(norm);
+
+            // no variance left along this axis
+            if(norm == 0)
+            {
+                w.assign(k, 0);
+                v.swap(w);
+                break;
+            }
+
+            double change = 0;
+
+            for(int p = 0; p < k; p++)
+            {
+                w[p] /= norm;
+                change += fabs(w[p] - v[p]);
+            }
+
+            v.swap(w);
+
+            if(change < 1e-9) break;
+        }
+
+        vectors.push_back(v);
+    }
+
+    return vectors;
+}
+
+// Rows of B times the axes.
+class PivotProject : public ThreadPool::Task
+{
+private:
+    PivotMds* mds;
+    const vector<vector<double> >& vectors;
+
+public:
+    PivotProject(PivotMds* mds, const vector<vector<double> >& vectors)
+        : mds(mds),
+          vectors(vectors)
+    {
+    }
+
+    void run(int chunk, int begin, int end)
+    {
+        int size = mds->size;
+        int k = mds->pivotCount;
+        const float* columns = &mds->columns[0];
+
+        for(int row = begin; row < end; row++)
+        {
+            Vrui::Point& position = mds->positions[row];
+
+            for(int axis = 0; axis < 3; axis++)
+            {
+                double x = 0;
+
+                for(int p = 0; p < k; p++)
+                {
+                    x += columns[(size_t)p * size + row] * vectors[axis][p];
+                }
+
+                position[axis] = x;
+            }
+        }
+    }
+};
+
+void PivotMds::project(const vector<vector<double> >& vectors)
+{
+    positions.assign(size, Vrui::Point(0, 0, 0));
+    PivotProject task(this, vectors);
+    application->threadPool->parallelFor(size, PIVOT_GRAIN, task);
+}
+
+// unit mean edge length, plus a little jitter
+void PivotMds::scale()
+{
+    double length = 0;
+    int count = 0;
+
+    foreach(int edge, snapshot->getEdges())
+    {
+        const Edge& e = snapshot->getEdge(edge);
+        length += Geometry::dist(positions[index[e.source]], positions[index[e.target]]);
+        count++;
+    }
+
+    double factor = (count > 0 && length > 0) ? count / length : 1;
+
+    foreach(Vrui::Point& p, positions)
+    {
+        for(int axis = 0; axis < 3; axis++)
+        {
+            p[axis] = p[axis] * factor + PIVOT_JITTER * (2 * VruiHelp::randomFloat() - 1);
+        }
+    }
+}
+
+// Returns false, leaving the graph alone, if there is no structure to
+// follow: fewer than two nodes or no edges.
+const bool PivotMds::place()
+{
+    // copy-on-write snapshot, the graph may change while we work
+    application->g->lock();
+    *snapshot = *application->g;
+    application->g->unlock();
+
+    nodes = snapshot->getNodes();
+    size = nodes.size();
+
+    if(size < 2 || snapshot->getEdgeCount() == 0)
+    {
+        return false;
+    }
+
+    index.assign(snapshot->getNodeCapacity(), -1);
+
+    for(int row = 0; row < size; row++)
+    {
+        index[nodes[row]] = row;
+    }
+
+    pivotCount = choosePivots();
+    center();
+    project(axes());
+    scale();
+
+    application->g->setNodePositions(nodes, positions);
+
+    // release the dense columns
+    vector<float>().swap(columns);
+    positions.clear();
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,71 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PIVOTMDS_HPP
+#define __PIVOTMDS_HPP
+
+#include <graph.hpp>
+#include <mycelia.hpp>
+#include <threadpool.hpp>
+
+#define PIVOT_COUNT 50 // BFS sources, more pivots follow the graph more closely
+#define PIVOT_GRAIN 4096 // nodes per chunk of the dense passes
+#define PIVOT_ITERATIONS 200 // power iteration limit per axis
+#define PIVOT_JITTER 0.1 // random offset in edge lengths, keeps flat graphs out of a plane
+
+/*
+ * Initial placement by pivot MDS (Brandes and Pich). Breadth first search
+ * from k pivots, each the node farthest from those already chosen, gives
+ * graph distances to every node. The double centered squared distances are
+ * projected onto the three leading eigenvectors of their k x k Gram matrix.
+ * The cost is O(k (N + E)) for the searches and O(k^2 N) for the product,
+ * so it can run in front of any layout. Edges are scaled to unit mean
+ * length; unreachable nodes count as one hop past the farthest one.
+ */
+class PivotMds
+{
+    friend class PivotCenter;
+    friend class PivotGram;
+    friend class PivotProject;
+
+private:
+    Mycelia* application;
+    Graph* snapshot;
+
+    int size;
+    int pivotCount;
+    std::vector<int> nodes; // graph node of each row
+    std::vector<int> index; // row of each graph node
+    std::vector<float> columns; // one column of n rows per pivot
+    std::vector<Vrui::Point> positions;
+
+    void search(int, std::vector<int>&);
+    const int choosePivots();
+    void center();
+    const std::vector<std::vector<double> > axes();
+    void project(const std::vector<std::vector<double> >&);
+    void scale();
+
+public:
+    PivotMds(Mycelia*);
+    ~PivotMds();
+
+    const bool place();
+};
+
+#endif
@@ -0,0 +1,435 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <layout/stresslayout.hpp>
+
+using namespace std;
+
+StressModel::StressModel(const bool* stopped)
+    : size(0),
+      exact(true),
+      etaMax(1),
+      lambda(0),
+      stopped(stopped)
+{
+}
+
+// Hop distances from one row, STRESS_UNREACHABLE where there is no path.
+void StressModel::search(int source, unsigned short* column, vector<int>& queue) const
+{
+    fill(column, column + size, (unsigned short)STRESS_UNREACHABLE);
+    queue.clear();
+
+    column[source] = 0;
+    queue.push_back(source);
+
+    for(int head = 0; head < (int)queue.size(); head++)
+    {
+        int row = queue[head];
+        int d = min(column[row] + 1, STRESS_UNREACHABLE - 1);
+
+        for(int i = offsets[row]; i < offsets[row + 1]; i++)
+        {
+            int next = neighbors[i];
+
+            if(column[next] == STRESS_UNREACHABLE)
+            {
+                column[next] = d;
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+void StressModel::run(ThreadPool* threadPool, ThreadPool::Task& task) const
+{
+    if(threadPool)
+    {
+        threadPool->parallelFor(size, LAYOUT_GRAIN, task);
+    }
+    else
+    {
+        task.run(0, 0, size);
+    }
+}
+
+// Breadth first search from every row, each writes its own column.
+class StressSearch : public ThreadPool::Task
+{
+private:
+    const StressModel* model;
+    vector<unsigned short>& distances;
+
+public:
+    StressSearch(const StressModel* model, vector<unsigned short>& distances)
+        : model(model),
+          distances(distances)
+    {
+    }
+
+    void run(int chunk, int begin, int end)
+    {
+        vector<int> queue;
+        queue.reserve(model->size);
+
+        for(int row = begin; row < end && !*model->stopped; row++)
+        {
+            model->search(row, &distances[(size_t)row * model->size], queue);
+        }
+    }
+};
+
+// Max-min pivots starting from the highest degree row. Each row then counts
+// towards the region of its closest pivot, the earliest on ties.
+void StressModel::choosePivots()
+{
+    int pivot = 0;
+
+    for(int row = 1; row < size; row++)
+    {
+        if(offsets[row + 1] - offsets[row] > offsets[pivot + 1] - offsets[pivot]) pivot = row;
+    }
+
+    int count = min(STRESS_PIVOTS, size);
+    distances.assign((size_t)count * size, 0);
+    pivots.clear();
+
+    vector<int> nearest(size, STRESS_UNREACHABLE + 1);
+    vector<int> owner(size, 0);
+    vector<int> queue;
+    queue.reserve(size);
+
+    for(int p = 0; p < count && !*stopped; p++)
+    {
+        unsigned short* column = &distances[(size_t)p * size];
+        search(pivot, column, queue);
+        pivots.push_back(pivot);
+
+        for(int row = 0; row < size; row++)
+        {
+            if(column[row] < nearest[row])
+            {
+                nearest[row] = column[row];
+                owner[row] = p;
+            }
+        }
+
+        // the next pivot is the row farthest from all chosen so far
+        for(int row = 0; row < size; row++)
+        {
+            if(nearest[row] > nearest[pivot]) pivot = row;
+        }
+
+        if(nearest[pivot] == 0) break;
+    }
+
+    distances.resize((size_t)pivots.size() * size);
+    regions.assign(pivots.size(), 0);
+
+    for(int row = 0; row < size; row++)
+    {
+        regions[owner[row]]++;
+    }
+}
+
+// Rows are the given nodes, in order; index maps a node id to its row or
+// -1, and edges to nodes without a row are left out.
+void StressModel::build(Graph* graph, const vector<int>& rows, const vector<int>& index,
+                        const vector<Vrui::Point>& start, ThreadPool* threadPool)
+{
+    nodes = rows;
+    size = nodes.size();
+    positions.clear();
+    positions.reserve(size);
+
+    foreach(int node, nodes)
+    {
+        positions.push_back(start[node]);
+    }
+
+    // undirected, without self loops or parallel edges
+    offsets.assign(1, 0);
+    neighbors.clear();
+
+    foreach(int node, nodes)
+    {
+        int begin = neighbors.size();
+
+        foreach(int edge, graph->getOutEdges(node))
+        {
+            int target = index[graph->getEdge(edge).target];
+            if(target != -1 && target != index[node]) neighbors.push_back(target);
+        }
+
+        foreach(int edge, graph->getInEdges(node))
+        {
+            int source = index[graph->getEdge(edge).source];
+            if(source != -1 && source != index[node]) neighbors.push_back(source);
+        }
+
+        sort(neighbors.begin() + begin, neighbors.end());
+        neighbors.erase(unique(neighbors.begin() + begin, neighbors.end()), neighbors.end());
+        offsets.push_back(neighbors.size());
+    }
+
+    exact = size <= STRESS_EXACT_SIZE;
+
+    if(exact)
+    {
+        pivots.resize(size);
+
+        for(int row = 0; row < size; row++)
+        {
+            pivots[row] = row;
+        }
+
+        distances.assign((size_t)size * size, 0);
+        regions.assign(size, 1);
+
+        StressSearch task(this, distances);
+        run(threadPool, task);
+    }
+    else
+    {
+        choosePivots();
+    }
+
+    // weights run from 1 / (longest distance)^2 up to the largest region
+    int longest = 1;
+    float heaviest = 1;
+
+    foreach(unsigned short d, distances)
+    {
+        if(d != STRESS_UNREACHABLE) longest = max(longest, (int)d);
+    }
+
+    foreach(float region, regions)
+    {
+        heaviest = max(heaviest, region);
+    }
+
+    etaMax = (double)longest * longest;
+    lambda = log(etaMax / (STRESS_EPSILON / heaviest)) / max(STRESS_ITERATIONS - 1, 1);
+}
+
+// Fixed pseudo random sequence per row and sweep, for the term order.
+static unsigned int mix(unsigned int h)
+{
+    h ^= h >> 16;
+    h *= 0x7feb352d;
+    h ^= h >> 15;
+    h *= 0x846ca68b;
+    h ^= h >> 16;
+    return h;
+}
+
+// One sweep over a range of rows. Terms 0..pivots-1 go to the pivots, the
+// rest (sparse mode only) to the row's neighbors at distance one.
+class StressStep : public ThreadPool::Task
+{
+private:
+    const StressModel* model;
+    int iteration;
+    double eta;
+
+public:
+    vector<Vrui::Point>& next;
+    vector<Vrui::Scalar>& moves;
+
+    StressStep(const StressModel* model, int iteration, double eta, vector<Vrui::Point>& next,
+               vector<Vrui::Scalar>& moves)
+        : model(model),
+          iteration(iteration),
+          eta(eta),
+          next(next),
+          moves(moves)
+    {
+    }
+
+    void run(int chunk, int begin, int end)
+    {
+        const vector<Vrui::Point>& positions = model->positions;
+        int size = model->size;
+        int pivotCount = model->pivots.size();
+        vector<int> order;
+
+        for(int row = begin; row < end && !*model->stopped; row++)
+        {
+            int neighborCount = model->exact ? 0 : model->offsets[row + 1] - model->offsets[row];
+            int termCount = pivotCount + neighborCount;
+
+            order.resize(termCount);
+
+            for(int i = 0; i < termCount; i++)
+            {
+                order[i] = i;
+            }
+
+            // Fisher-Yates
+            unsigned int h = mix(row * 2654435761u + iteration);
+
+            for(int i = termCount - 1; i > 0; i--)
+            {
+                h = mix(h + i);
+                swap(order[i], order[h % (i + 1)]);
+            }
+
+            Vrui::Point p = positions[row];
+
+            foreach(int term, order)
+            {
+                int other;
+                Vrui::Scalar d;
+                Vrui::Scalar weight;
+
+                if(term < pivotCount)
+                {
+                    other = model->pivots[term];
+                    d = model->distances[(size_t)term * size + row];
+
+                    if(d == 0 || d == STRESS_UNREACHABLE) continue;
+
+                    weight = model->regions[term] / (d * d);
+                }
+                else
+                {
+                    other = model->neighbors[model->offsets[row] + term - pivotCount];
+                    d = 1;
+                    weight = 1;
+                }
+
+                Vrui::Vector v = p - positions[other];
+                Vrui::Scalar mag = Geometry::mag(v);
+
+                if(mag == 0) continue;
+
+                // each end of a pair covers half the error
+                Vrui::Scalar mu = min(eta * weight, 1.0);
+                p -= v * (mu * (mag - d) / (2 * mag));
+            }
+
+            next[row] = p;
+            moves[row] = Geometry::dist(p, positions[row]);
+        }
+    }
+};
+
+// One sweep of the schedule. Returns true once the layout has converged,
+// run out of sweeps or been stopped.
+const bool StressModel::iterate(int iteration, ThreadPool* threadPool)
+{
+    if(iteration >= STRESS_ITERATIONS || size < 2 || *stopped) return true;
+
+    vector<Vrui::Point> next(size);
+    vector<Vrui::Scalar> moves(size, 0);
+
+    StressStep step(this, iteration, etaMax * exp(-lambda * iteration), next, moves);
+    run(threadPool, step);
+
+    if(*stopped) return true;
+
+    positions.swap(next);
+
+    return *max_element(moves.begin(), moves.end()) < STRESS_TOLERANCE;
+}
+
+void StressModel::solve(ThreadPool* threadPool)
+{
+    for(int iteration = 0; !iterate(iteration, threadPool); iteration++)
+    {
+    }
+}
+
+void StressModel::clear()
+{
+    size = 0;
+    nodes.clear();
+    offsets.clear();
+    neighbors.clear();
+    pivots.clear();
+    vector<unsigned short>().swap(distances);
+    regions.clear();
+    positions.clear();
+}
+
+/*
+ * layout
+ */
+StressLayout::StressLayout(Mycelia* application)
+    : GraphLayout(application),
+      model(&stopped)
+{
+    snapshot = new Graph(application);
+}
+
+StressLayout::~StressLayout()
+{
+    stop();
+    delete snapshot;
+}
+
+void StressLayout::publish()
+{
+    application->g->setLayoutPositions(model.nodes, model.positions);
+}
+
+void* StressLayout::layout()
+{
+    // copy-on-write snapshot, the graph may change while we work
+    application->g->lock();
+    *snapshot = *application->g;
+    application->g->unlock();
+
+    vector<int> nodes;
+    vector<int> index(snapshot->getNodeCapacity(), -1);
+
+    foreach(int node, snapshot->getNodes())
+    {
+        if(application->isSelectedComponent(node))
+        {
+            index[node] = nodes.size();
+            nodes.push_back(node);
+        }
+    }
+
+    model.build(snapshot, nodes, index, snapshot->getNodePositions(), application->threadPool);
+
+    for(int iteration = 0; !stopped; iteration++)
+    {
+        bool done = model.iterate(iteration, application->threadPool);
+        publish();
+
+        if(done)
+        {
+            break;
+        }
+    }
+
+    model.clear();
+
+    // only complete runs are worth keeping
+    if(!stopped)
+    {
+        application->layoutFinished();
+    }
+
+    stopped = true;
+    application->resetNavigationCallback(0);
+
+    return 0;
+}
\ No newline at end of file
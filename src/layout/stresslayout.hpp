@@ -0,0 +1,104 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __STRESSLAYOUT_HPP
+#define __STRESSLAYOUT_HPP
+
+#include <graph.hpp>
+#include <mycelia.hpp>
+#include <threadpool.hpp>
+#include <layout/graphlayout.hpp>
+
+#define STRESS_EXACT_SIZE 2000 // all pairs up to this many nodes, pivots beyond
+#define STRESS_PIVOTS 50 // pivots of the sparse approximation
+#define STRESS_ITERATIONS 30 // bound on the annealing schedule
+#define STRESS_EPSILON 0.1 // final step, as a fraction of the heaviest term's
+#define STRESS_TOLERANCE 0.03 // largest move, in edge lengths, that ends the layout
+#define STRESS_UNREACHABLE 0xffff
+
+/*
+ * Stress majorization by stochastic gradient descent, after Zheng, Pawar
+ * and Goodman. Every term pulls a pair of nodes towards their graph
+ * distance (in unit edge lengths) with weight 1 / d^2; the step size is
+ * annealed exponentially from 1 / smallest weight down to STRESS_EPSILON /
+ * largest weight.
+ *
+ * Up to STRESS_EXACT_SIZE nodes the terms cover all pairs, found by a
+ * breadth first search from every node. Larger graphs use the sparse
+ * approximation of Ortmann et al.: edges plus terms to max-min pivots,
+ * each weighted by the number of nodes closest to its pivot.
+ *
+ * Each sweep visits every node once, in parallel. A node applies its terms
+ * in a shuffled order to its own position, against the positions of the
+ * previous sweep, so the result does not depend on the thread count.
+ *
+ * StressModel holds the terms and positions over one set of rows; a null
+ * thread pool runs it on the calling thread.
+ */
+class StressModel
+{
+    friend class StressSearch;
+    friend class StressStep;
+
+private:
+    int size;
+    std::vector<int> offsets; // CSR adjacency between rows, both directions
+    std::vector<int> neighbors;
+    std::vector<int> pivots; // every row when exact
+    std::vector<unsigned short> distances; // one column of size rows per pivot
+    std::vector<float> regions; // nodes closest to each pivot
+    bool exact;
+    double etaMax;
+    double lambda;
+    const bool* stopped; // the owning layout's flag
+
+    void search(int, unsigned short*, std::vector<int>&) const;
+    void choosePivots();
+    void run(ThreadPool*, ThreadPool::Task&) const;
+
+public:
+    std::vector<int> nodes; // graph node of each row
+    std::vector<Vrui::Point> positions;
+
+    StressModel(const bool*);
+
+    void build(Graph*, const std::vector<int>&, const std::vector<int>&,
+               const std::vector<Vrui::Point>&, ThreadPool*);
+    const bool iterate(int, ThreadPool*);
+    void solve(ThreadPool*);
+    void clear();
+};
+
+class StressLayout : public GraphLayout
+{
+private:
+    StressModel model;
+
+    Graph* snapshot;
+
+    void publish();
+
+public:
+    StressLayout(Mycelia*);
+    ~StressLayout();
+
+protected:
+    virtual void* layout();
+};
+
+#endif
@@ -21,6 +21,8 @@
 #include <dataitem.hpp>
 #include <graph.hpp>
 #include <mycelia.hpp>
+#include <positionbuffer.hpp>
+#include <threadpool.hpp>
 #include <vruihelp.hpp>
 #include <generators/barabasigenerator.hpp>
 #include <generators/erdosgenerator.hpp>
@@ -28,9 +30,15 @@
 #include <generators/wattsgenerator.hpp>
 #include <layout/arflayout.hpp>
 #include <layout/arfwindow.hpp>
+#include <layout/componentlayout.hpp>
+#include <layout/cpulayout.hpp>
 #include <layout/edgebundler.hpp>
 #include <layout/frlayout.hpp>
 #include <layout/graphlayout.hpp>
+#include <layout/layoutcache.hpp>
+#include <layout/multilevellayout.hpp>
+#include <layout/pivotmds.hpp>
+#include <layout/stresslayout.hpp>
 #include <parsers/chacoparser.hpp>
 #include <parsers/dotparser.hpp>
 #include <parsers/gmlparser.hpp>
@@ -48,14 +56,6 @@
 
 using namespace std;
 
-/*
- * link to gpu layout function if cuda is enabled
- */
-#ifdef __CUDA__
-#include <vector_types.h>
-extern "C" { void gpuLayout(float4*, int*, int); }
-#endif
-
 /** Returns the base directory for resource files.
 *
 * Returns RESOURCEDIR if it exists or
@@ -76,14 +76,98 @@ std::string getResourceDir()
     return dir;
 }
 
+/** Converts a material color to bytes for a vertex buffer.
+*/
+static void toColorBytes(const GLMaterial::Color& color, GLubyte* bytes)
+{
+    for(int i = 0; i < 4; i++)
+    {
+        bytes[i] = (GLubyte)(std::max(0.0f, std::min((float)color[i], 1.0f)) * 255 + 0.5);
+    }
+}
+
+/** Appends the quad of one straight edge piece.
+*
+* The radius may differ at either end, an arrow head narrows to 0.
+*/
+static void appendEdgePiece(std::vector<EdgeVertex>& vertices,
+                            const Vrui::Point& from, const Vrui::Point& to,
+                            GLfloat fromRadius, GLfloat toRadius, const GLubyte* color)
+{
+    static const GLfloat sides[4] = {-1, 1, 1, -1};
+
+    EdgeVertex v;
+
+    for(int i = 0; i < 3; i++)
+    {
+        v.axis[i] = to[i] - from[i];
+    }
+
+    for(int i = 0; i < 4; i++)
+    {
+        v.color[i] = color[i];
+    }
+
+    // counter-clockwise so that the quad faces front
+    for(int i = 0; i < 4; i++)
+    {
+        const Vrui::Point& end = i < 2 ? from : to;
+        v.side[0] = sides[i];
+        v.side[1] = i < 2 ? fromRadius : toRadius;
+
+        for(int axis = 0; axis < 3; axis++)
+        {
+            v.position[axis] = end[axis];
+        }
+
+        vertices.push_back(v);
+    }
+}
+
 Mycelia::Mycelia(int argc, char** argv, char** appDefaults)
     : Vrui::Application(argc, argv, appDefaults)
 {
+    // worker threads, one per core unless given with -threads
+    int threadCount = ThreadPool::getDefaultThreadCount();
+
+    // one shot layout on reset, default with cuda and -accelerated otherwise
+#ifdef __CUDA__
+    acceleratedLayout = true;
+#else
+    acceleratedLayout = false;
+#endif
+
+    for(int i = 1; i < argc; i++)
+    {
+        if(strcmp(argv[i], "-threads") == 0 && i < argc - 1)
+        {
+            threadCount = max(1, atoi(argv[i + 1]));
+        }
+        else if(strcmp(argv[i], "-accelerated") == 0)
+        {
+            acceleratedLayout = true;
+        }
+        else if(strcmp(argv[i], "-seed") == 0 && i < argc - 1)
+        {
+            VruiHelp::seedRandom(strtoull(argv[i + 1], 0, 10));
+        }
+    }
+
+    threadPool = new ThreadPool(threadCount);
+
     // node layout / edge bundler
     dynamicLayout = new ArfLayout(this);
     staticLayout = new FruchtermanReingoldLayout(this);
+    multilevelLayout = new MultilevelLayout(this);
+    stressLayout = new StressLayout(this);
+    componentLayout = new ComponentLayout(this);
     edgeBundler = new EdgeBundler(this);
+    pivotMds = new PivotMds(this);
+    layoutCache = new LayoutCache(this);
     skipLayout = false;
+    warmStart = false;
+    cachedLayout = false;
+    placementLayout = 0;
 
     // node selection tool factory
     NodeSelectorFactory* selectorFactory = new NodeSelectorFactory(*Vrui::getToolManager(), this);
@@ -121,6 +205,9 @@ Mycelia::Mycelia(int argc, char** argv, char** appDefaults)
 
     staticButton = new GLMotif::ToggleButton("StaticButton", layoutRadioBox, "Static");
     dynamicButton = new GLMotif::ToggleButton("DynamicButton", layoutRadioBox, "Dynamic");
+    multilevelButton = new GLMotif::ToggleButton("MultilevelButton", layoutRadioBox, "Multilevel");
+    stressButton = new GLMotif::ToggleButton("StressButton", layoutRadioBox, "Stress");
+    componentLayoutButton = new GLMotif::ToggleButton("ComponentLayoutButton", layoutRadioBox, "Components");
     layout = staticLayout;
 
     // render submenu
@@ -130,6 +217,9 @@ Mycelia::Mycelia(int argc, char** argv, char** appDefaults)
     bundleButton = new GLMotif::ToggleButton("BundleButton", renderSubMenu, "Bundle Edges");
     bundleButton->getValueChangedCallbacks().add(this, &Mycelia::bundleCallback);
 
+    densityBundleButton = new GLMotif::ToggleButton("DensityBundleButton", renderSubMenu, "Bundle Edges By Density");
+    densityBundleButton->getValueChangedCallbacks().add(this, &Mycelia::bundleCallback); // same callback
+
     nodeInfoButton = new GLMotif::ToggleButton("NodeInfoButton", renderSubMenu, "Show Node Information");
     nodeInfoButton->getValueChangedCallbacks().add(this, &Mycelia::nodeInfoCallback);
 
@@ -262,6 +352,9 @@ Mycelia::Mycelia(int argc, char** argv, char** appDefaults)
     // graph
     g = new Graph(this);
     gCopy = new Graph(this);
+    positionBuffer = new PositionBuffer();
+    renderVersion = 0;
+    graphVersion = 0;
 
     // establishes initial node+edge sizes if graph builder is used first
     resetNavigationCallback(0);
@@ -270,13 +363,76 @@ Mycelia::Mycelia(int argc, char** argv, char** appDefaults)
 Mycelia::~Mycelia()
 {
     stopLayout();
+
+    delete staticLayout;
+    delete dynamicLayout;
+    delete multilevelLayout;
+    delete stressLayout;
+    delete componentLayout;
+    delete edgeBundler;
+    delete pivotMds;
+    delete layoutCache;
+    delete threadPool;
 }
 
-void Mycelia::buildGraphList(MyceliaDataItem* dataItem) const
+// Records what each shape node and edge draws, the buffers' vertices are
+// filled from them by fillBuffers.
+void Mycelia::buildBuffers(MyceliaDataItem* dataItem) const
 {
-    // update version first in case of preemption
-    dataItem->graphListVersion = gCopy->getVersion();
+    static const GLfloat corners[4][2] = {{-1, -1}, {1, -1}, {1, 1}, {-1, 1}};
+
+    dataItem->bufferNodes.clear();
+    dataItem->nodeVertices.clear();
+
+    foreach(int node, gCopy->getNodes())
+    {
+        if(!isSelectedComponent(node) || gCopy->getNodeType(node) != "shape")
+        {
+            continue;
+        }
+
+        NodeVertex v;
+        v.corner[2] = nodeRadius * gCopy->getNodeSize(node);
+        toColorBytes(getShapeNodeMaterial(node)->diffuse, v.color);
+
+        for(int i = 0; i < 4; i++)
+        {
+            v.corner[0] = corners[i][0];
+            v.corner[1] = corners[i][1];
+            dataItem->nodeVertices.push_back(v);
+        }
+
+        dataItem->bufferNodes.push_back(node);
+    }
+
+    dataItem->bufferEdges.clear();
+
+    foreach(int edge, gCopy->getEdges())
+    {
+        const Edge& e = gCopy->getEdge(edge);
+
+        // parallel edges are drawn once
+        if(!isSelectedComponent(e.source) || *gCopy->getEdges(e.source, e.target).first != edge)
+        {
+            continue;
+        }
 
+        EdgeRecord r;
+        r.edge = edge;
+        r.source = e.source;
+        r.target = e.target;
+        toColorBytes(gCopy->getEdgeMaterial(edge)->diffuse, r.color);
+        r.radius = edgeThickness * e.weight;
+        r.sourceOffset = getNodeEdgeOffset(e.source, dataItem);
+        r.targetOffset = getNodeEdgeOffset(e.target, dataItem);
+        r.bidirectional = gCopy->isBidirectional(e.source, e.target);
+
+        dataItem->bufferEdges.push_back(r);
+    }
+}
+
+void Mycelia::buildGraphList(MyceliaDataItem* dataItem) const
+{
     glNewList(dataItem->nodeList, GL_COMPILE);
     gluSphere(dataItem->quadric, nodeRadius, 20, 20);
     glEndList();
@@ -289,6 +445,9 @@ void Mycelia::buildGraphList(MyceliaDataItem* dataItem) const
     gluQuadricOrientation(dataItem->quadric, GLU_OUTSIDE);
     glEndList();
 
+    // impostors draw the graph from buffers instead
+    if (dataItem->impostors) return;
+
     glNewList(dataItem->graphList, GL_COMPILE);
 
     // Camera aligned texture nodes cannot be part of the display list since
@@ -307,6 +466,44 @@ void Mycelia::buildGraphList(MyceliaDataItem* dataItem) const
     glEndList();
 }
 
+void Mycelia::drawBuffers(MyceliaDataItem* dataItem) const
+{
+    glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glEnableClientState(GL_COLOR_ARRAY);
+    glEnableClientState(GL_VERTEX_ARRAY);
+
+    // offsets into the bound buffer
+    if(!dataItem->nodeVertices.empty())
+    {
+        glBindBufferARB(GL_ARRAY_BUFFER_ARB, dataItem->nodeBuffer);
+        glTexCoordPointer(3, GL_FLOAT, sizeof(NodeVertex), (const GLvoid*)offsetof(NodeVertex, corner));
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(NodeVertex), (const GLvoid*)offsetof(NodeVertex, color));
+        glVertexPointer(3, GL_FLOAT, sizeof(NodeVertex), (const GLvoid*)offsetof(NodeVertex, position));
+
+        dataItem->nodeShader.useProgram();
+        glDrawArrays(GL_QUADS, 0, dataItem->nodeVertices.size());
+    }
+
+    // the piece's axis rides in the normal
+    if(!dataItem->edgeVertices.empty())
+    {
+        glEnableClientState(GL_NORMAL_ARRAY);
+        glBindBufferARB(GL_ARRAY_BUFFER_ARB, dataItem->edgeBuffer);
+        glTexCoordPointer(2, GL_FLOAT, sizeof(EdgeVertex), (const GLvoid*)offsetof(EdgeVertex, side));
+        glNormalPointer(GL_FLOAT, sizeof(EdgeVertex), (const GLvoid*)offsetof(EdgeVertex, axis));
+        glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(EdgeVertex), (const GLvoid*)offsetof(EdgeVertex, color));
+        glVertexPointer(3, GL_FLOAT, sizeof(EdgeVertex), (const GLvoid*)offsetof(EdgeVertex, position));
+
+        dataItem->edgeShader.useProgram();
+        glDrawArrays(GL_QUADS, 0, dataItem->edgeVertices.size());
+    }
+
+    GLShader::disablePrograms();
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+    glPopClientAttrib();
+}
+
 void Mycelia::drawEdge(const Edge& edge, MyceliaDataItem* dataItem) const
 {
     drawEdge(gCopy->getNodePosition(edge.source),
@@ -385,6 +582,9 @@ void Mycelia::drawEdges(MyceliaDataItem* dataItem) const
     const GLMaterial *material;
     Vrui::Scalar width;
 
+    // a new bundling run may replace the points otherwise
+    edgeBundler->lockPoints();
+
     foreach(int edge, gCopy->getEdges())
     {
         const Edge& e = gCopy->getEdge(edge);
@@ -394,15 +594,19 @@ void Mycelia::drawEdges(MyceliaDataItem* dataItem) const
             continue;
         }
 
-        if(bundleButton->getToggle())
+        // edges added since bundling started are drawn straight
+        int segments = edgeBundler->getSegmentCount();
+        bool bundled = bundleButton->getToggle() || densityBundleButton->getToggle();
+        const Vrui::Point* points = bundled ? edgeBundler->getPoints(edge) : 0;
+
+        if(points)
         {
             material = gCopy->getEdgeMaterial(edge);
             width = edgeThickness * e.weight;
-            for(int segment = 0; segment <= edgeBundler->getSegmentCount(); segment++)
+
+            for(int segment = 0; segment <= segments; segment++)
             {
-                const Vrui::Point& p = *edgeBundler->getSegment(edge, segment);
-                const Vrui::Point& q = *edgeBundler->getSegment(edge, segment + 1);
-                drawEdge(p, q, material, width, false, false, dataItem);
+                drawEdge(points[segment], points[segment + 1], material, width, false, false, dataItem);
             }
         }
         else
@@ -411,6 +615,8 @@ void Mycelia::drawEdges(MyceliaDataItem* dataItem) const
             drawn[e.source][e.target] = true;
         }
     }
+
+    edgeBundler->unlockPoints();
 }
 
 void Mycelia::drawEdgeLabels(MyceliaDataItem* dataItem) const
@@ -560,16 +766,7 @@ bool Mycelia::drawShapeNode(int node, MyceliaDataItem* dataItem) const
     const Vrui::Point& p = gCopy->getNodePosition(node);
     const float size = gCopy->getNodeSize(node);
 
-    if(node == highlightedNode)
-    {
-        glMaterial(GLMaterialEnums::FRONT_AND_BACK, *gCopy->getNodeMaterialFromId(MATERIAL_HIGHLIGHTED));
-    }
-    else if(node == selectedNode)
-        glMaterial(GLMaterialEnums::FRONT_AND_BACK, *gCopy->getNodeMaterialFromId(MATERIAL_SELECTED));
-    else if(node == previousNode)
-        glMaterial(GLMaterialEnums::FRONT_AND_BACK, *gCopy->getNodeMaterialFromId(MATERIAL_SELECTED_PREVIOUS));
-    else
-        glMaterial(GLMaterialEnums::FRONT_AND_BACK, *gCopy->getNodeMaterial(node));
+    glMaterial(GLMaterialEnums::FRONT_AND_BACK, *getShapeNodeMaterial(node));
 
     glPushMatrix();
     glTranslatef(p[0], p[1], p[2]);
@@ -698,10 +895,25 @@ void Mycelia::display(GLContextData& contextData) const
         return;
     }
 
-    // re-create display list if it's been updated
-    if(dataItem->graphListVersion != gCopy->getVersion())
+    // Re-create display lists if they've been updated. With impostors only
+    // graph changes do that, motion alone refills the buffers.
+    int listVersion = dataItem->impostors ? graphVersion : renderVersion;
+
+    if(dataItem->graphListVersion != listVersion)
     {
+        // update version first in case of preemption
+        dataItem->graphListVersion = listVersion;
         buildGraphList(dataItem);
+
+        if(dataItem->impostors)
+        {
+            buildBuffers(dataItem);
+        }
+    }
+
+    if(dataItem->impostors && dataItem->bufferPositionVersion != renderVersion)
+    {
+        fillBuffers(dataItem);
     }
 
     if(spanningTreeButton->getToggle())
@@ -710,16 +922,27 @@ void Mycelia::display(GLContextData& contextData) const
     }
     else
     {
-        glCallList(dataItem->graphList);
-
-        // Camera aligned texture nodes must be redrawn each time.
-        // Rotatable texture nodes will be in the display list and thus
-        // will rotate so long as we don't redraw the display list.
-        if (gCopy->getTextureNodeMode() == "align")
+        if(dataItem->impostors)
         {
+            drawBuffers(dataItem);
+
+            // texture nodes are few, they follow the layout directly
             std::string filter = "shape";
             drawNodes(dataItem, filter);
         }
+        else
+        {
+            glCallList(dataItem->graphList);
+
+            // Camera aligned texture nodes must be redrawn each time.
+            // Rotatable texture nodes will be in the display list and thus
+            // will rotate so long as we don't redraw the display list.
+            if (gCopy->getTextureNodeMode() == "align")
+            {
+                std::string filter = "shape";
+                drawNodes(dataItem, filter);
+            }
+        }
 
         // Haven't figure out what FTGLTextureFont::Render() is changing...
         // but unless we push GL_TEXTURE_BIT, the rendered text disappears on
@@ -772,6 +995,99 @@ double Mycelia::getNodeEdgeOffset(int node, MyceliaDataItem* dataItem) const
     return offset;
 }
 
+const GLMaterial* Mycelia::getShapeNodeMaterial(int node) const
+{
+    if(node == highlightedNode)
+    {
+        return gCopy->getNodeMaterialFromId(MATERIAL_HIGHLIGHTED);
+    }
+    else if(node == selectedNode)
+    {
+        return gCopy->getNodeMaterialFromId(MATERIAL_SELECTED);
+    }
+    else if(node == previousNode)
+    {
+        return gCopy->getNodeMaterialFromId(MATERIAL_SELECTED_PREVIOUS);
+    }
+
+    return gCopy->getNodeMaterial(node);
+}
+
+// Refills the buffers' vertices from the records and the current positions.
+void Mycelia::fillBuffers(MyceliaDataItem* dataItem) const
+{
+    // update version first in case of preemption
+    dataItem->bufferPositionVersion = renderVersion;
+
+    std::vector<NodeVertex>& nodeVertices = dataItem->nodeVertices;
+
+    for(int i = 0; i < (int)dataItem->bufferNodes.size(); i++)
+    {
+        const Vrui::Point& p = gCopy->getNodePosition(dataItem->bufferNodes[i]);
+
+        for(int corner = 4 * i; corner < 4 * i + 4; corner++)
+        {
+            for(int axis = 0; axis < 3; axis++)
+            {
+                nodeVertices[corner].position[axis] = p[axis];
+            }
+        }
+    }
+
+    std::vector<EdgeVertex>& edgeVertices = dataItem->edgeVertices;
+    edgeVertices.clear();
+
+    // edges added since bundling started are drawn straight
+    bool bundled = bundleButton->getToggle() || densityBundleButton->getToggle();
+    edgeBundler->lockPoints();
+    int segments = edgeBundler->getSegmentCount();
+
+    foreach(const EdgeRecord& r, dataItem->bufferEdges)
+    {
+        const Vrui::Point* points = bundled ? edgeBundler->getPoints(r.edge) : 0;
+
+        if(points)
+        {
+            for(int segment = 0; segment <= segments; segment++)
+            {
+                appendEdgePiece(edgeVertices, points[segment], points[segment + 1], r.radius, r.radius, r.color);
+            }
+
+            continue;
+        }
+
+        // the same room for nodes and arrow heads as drawEdge leaves
+        const Vrui::Point& source = gCopy->getNodePosition(r.source);
+        const Vrui::Vector edgeVector = gCopy->getNodePosition(r.target) - source;
+        const Vrui::Scalar length = Geometry::mag(edgeVector);
+
+        if(length == 0) continue;
+
+        const Vrui::Vector direction = edgeVector / length;
+        Vrui::Scalar start = r.sourceOffset + (r.bidirectional ? edgeOffset : 0);
+        Vrui::Scalar end = length - r.targetOffset - edgeOffset;
+
+        if(end > start)
+        {
+            appendEdgePiece(edgeVertices, source + direction * start, source + direction * end,
+                            r.radius, r.radius, r.color);
+        }
+
+        appendEdgePiece(edgeVertices, source + direction * end, source + direction * (end + arrowHeight),
+                        arrowWidth, 0, r.color);
+    }
+
+    edgeBundler->unlockPoints();
+
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, dataItem->nodeBuffer);
+    glBufferDataARB(GL_ARRAY_BUFFER_ARB, nodeVertices.size() * sizeof(NodeVertex),
+                    nodeVertices.empty() ? 0 : &nodeVertices[0], GL_STREAM_DRAW_ARB);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, dataItem->edgeBuffer);
+    glBufferDataARB(GL_ARRAY_BUFFER_ARB, edgeVertices.size() * sizeof(EdgeVertex),
+                    edgeVertices.empty() ? 0 : &edgeVertices[0], GL_STREAM_DRAW_ARB);
+    glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
+}
+
 void Mycelia::frame()
 {
     double newFrameTime = Vrui::getApplicationTime();
@@ -779,10 +1095,29 @@ void Mycelia::frame()
     rotationAngle = Math::mod(rotationAngle, Vrui::Scalar(360));
     lastFrameTime = newFrameTime;
 
+    // keep checking while a client holds a transaction open
+    if(g->expireTransaction())
+    {
+        Vrui::scheduleUpdate(newFrameTime + 1);
+    }
+
+    // graph arrays are shared copy-on-write, so a snapshot is cheap and an
+    // unchanged graph is not copied at all
     g->lock();
-    *gCopy = *g;
+    if(gCopy->getVersion() != g->getVersion())
+    {
+        *gCopy = *g;
+        renderVersion++;
+        graphVersion++;
+    }
     g->unlock();
 
+    // layout motion arrives separately, take the newest frame if any
+    if(positionBuffer->acquire() && gCopy->readLayout(*positionBuffer))
+    {
+        renderVersion++;
+    }
+
     if(gCopy->getNodeCount() == 0)
     {
         if (!showingLogo)
@@ -855,6 +1190,44 @@ void Mycelia::setStatus(const char* status) const
 /*
  * layout
  */
+// the layout type followed by the layout's own settings
+void Mycelia::getLayoutParameters(vector<double>& parameters) const
+{
+    int type = LAYOUT_STATIC;
+
+    if(layout == dynamicLayout) type = LAYOUT_DYNAMIC;
+    else if(layout == multilevelLayout) type = LAYOUT_MULTILEVEL;
+    else if(layout == stressLayout) type = LAYOUT_STRESS;
+    else if(layout == componentLayout) type = LAYOUT_COMPONENTS;
+
+    parameters.assign(1, type);
+    layout->getParameters(parameters);
+}
+
+// Called by a layout that ran to completion, keeps the result for next time.
+void Mycelia::layoutFinished() const
+{
+    cacheSourceMutex.lock();
+    string source = cacheSource;
+    cacheSourceMutex.unlock();
+
+    if(source.empty()) return;
+
+    vector<double> parameters;
+    getLayoutParameters(parameters);
+    layoutCache->store(source, parameters);
+}
+
+// called from the dynamic layout thread when it goes to sleep
+void Mycelia::layoutSettled() const
+{
+    layoutFinished();
+
+#ifdef __RPCSERVER__
+    server->settled();
+#endif
+}
+
 void Mycelia::resumeLayout() const
 {
     // Resume only if dynamic and not skipping.
@@ -873,12 +1246,20 @@ bool Mycelia::layoutIsStopped() const
     return layout->isStopped();
 }
 
+void Mycelia::setCacheSource(const string& source)
+{
+    cacheSourceMutex.lock();
+    cacheSource = source;
+    cacheSourceMutex.unlock();
+}
+
 void Mycelia::setLayoutType(int type)
 {
     if(type == LAYOUT_DYNAMIC)
     {
         edgeBundler->stop();
         bundleButton->setToggle(false);
+        densityBundleButton->setToggle(false);
 
         layoutRadioBox->setSelectedToggle(1);
         if (layout != dynamicLayout)
@@ -900,6 +1281,41 @@ void Mycelia::setLayoutType(int type)
         layout = staticLayout;
         layoutWindow->hide();
     }
+    else if(type == LAYOUT_MULTILEVEL)
+    {
+        layoutRadioBox->setSelectedToggle(2);
+        if (layout != multilevelLayout)
+        {
+            // Then we are switching layouts!
+            stopLayout();
+        }
+        layout = multilevelLayout;
+        layoutWindow->hide();
+    }
+    else if(type == LAYOUT_STRESS)
+    {
+        layoutRadioBox->setSelectedToggle(3);
+        if (layout != stressLayout)
+        {
+            // Then we are switching layouts!
+            stopLayout();
+        }
+        layout = stressLayout;
+        layoutWindow->hide();
+    }
+    else if(type == LAYOUT_COMPONENTS)
+    {
+        layoutRadioBox->setSelectedToggle(4);
+        if (layout != componentLayout)
+        {
+            // Then we are switching layouts!
+            stopLayout();
+        }
+        layout = componentLayout;
+        layoutWindow->hide();
+    }
+
+    g->setDynamicLayout(layout->isDynamic());
 }
 
 void Mycelia::setSkipLayout(bool skipLayout)
@@ -917,6 +1333,14 @@ void Mycelia::stopLayout() const
     edgeBundler->stop();
     staticLayout->stop();
     dynamicLayout->stop();
+    multilevelLayout->stop();
+    stressLayout->stop();
+    componentLayout->stop();
+}
+
+void Mycelia::wakeLayout() const
+{
+    dynamicLayout->wake(false);
 }
 
 /*
@@ -928,13 +1352,19 @@ void Mycelia::bundleCallback(GLMotif::ToggleButton::ValueChangedCallbackData* cb
 
     if(cbData->set)
     {
+        // the two bundling modes exclude each other
+        bool density = cbData->toggle == densityBundleButton;
+        (density ? bundleButton : densityBundleButton)->setToggle(false);
+
         stopLayout();
+        edgeBundler->stop();
+        edgeBundler->setMode(density ? BUNDLE_DENSITY : BUNDLE_PAIRWISE);
         edgeBundler->start();
     }
     else
     {
         edgeBundler->stop();
-        g->update();
+        g->redraw();
         resumeLayout();
     }
 }
@@ -942,9 +1372,11 @@ void Mycelia::bundleCallback(GLMotif::ToggleButton::ValueChangedCallbackData* cb
 void Mycelia::clearCallback(Misc::CallbackData* cbData)
 {
     g->clear();
+    setCacheSource("");
 
     // clear menu toggles
     bundleButton->setToggle(false);
+    densityBundleButton->setToggle(false);
     componentButton->setToggle(false);
     centralityButton->setToggle(false);
     degreeButton->setToggle(false);
@@ -1007,7 +1439,21 @@ void Mycelia::fileOpen(string &filename)
         gmlParser->parse(filename);
     }
 
-    // reset navigation here in case skipLayout is true
+    // a cached layout of this graph replaces running the layout, a near
+    // match gives it a warm start
+    setCacheSource(filename);
+
+    if(!skipLayout)
+    {
+        vector<double> parameters;
+        getLayoutParameters(parameters);
+        int cached = layoutCache->restore(filename, parameters);
+
+        cachedLayout = cached == CACHE_HIT;
+        warmStart = cached == CACHE_NEAR_HIT;
+    }
+
+    // reset navigation here in case the layout is skipped
     resetNavigationCallback(0);
     resetLayoutCallback(0);
 }
@@ -1023,6 +1469,7 @@ void Mycelia::fileOpenAction(GLMotif::FileSelectionDialog::OKCallbackData* cbDat
 void Mycelia::generatorCallback(GLMotif::RadioBox::ValueChangedCallbackData* cbData)
 {
     g->clear();
+    setCacheSource("");
 
     setLayoutType(LAYOUT_DYNAMIC);
     generator->hide();
@@ -1058,7 +1505,7 @@ void Mycelia::nodeInfoCallback(GLMotif::ToggleButton::ValueChangedCallbackData*
 
 void Mycelia::nodeLabelCallback(GLMotif::ToggleButton::ValueChangedCallbackData* cbData)
 {
-    g->update();
+    g->redraw();
 }
 
 void Mycelia::openFileCallback(Misc::CallbackData* cbData)
@@ -1114,9 +1561,9 @@ void Mycelia::pythonCallback(GLMotif::RadioBox::ValueChangedCallbackData* cbData
 
         ofstream out("/tmp/input.txt");
 
-        for(int source = 0; source < gCopy->getNodeCount(); source++)
+        for(int source = 0; source < gCopy->getNodeCapacity(); source++)
         {
-            for(int target = 0; target < gCopy->getNodeCount(); target++)
+            for(int target = 0; target < gCopy->getNodeCapacity(); target++)
             {
                 out << a[source][target] << " ";
             }
@@ -1154,88 +1601,179 @@ void Mycelia::resetLayoutCallback(Misc::CallbackData* cbData)
     resetLayout();
 }
 
+// Reset layout state, starting from the graph's global shape unless the
+// layout cache already gave a close one. Returns true if it did either.
+const bool Mycelia::placeNodes(bool warm)
+{
+    bool placed = warm || pivotMds->place();
+
+    if(!placed)
+    {
+        g->randomizePositions(100);
+    }
+
+    staticLayout->setWarmStart(placed);
+
+    g->clearVelocities();
+
+    return placed;
+}
+
+// Called by every layout thread as it starts, places the nodes if the last
+// reset left that to this layout.
+void Mycelia::placeLayout(const GraphLayout* caller)
+{
+    placementMutex.lock();
+
+    bool pending = placementLayout == caller;
+    bool warm = placementWarm;
+    bool watch = placementWatch;
+
+    if(pending) placementLayout = 0;
+
+    placementMutex.unlock();
+
+    if(!pending) return;
+
+    placeNodes(warm);
+
+    // In order to avoid a flicker during layout...let's recenter. This
+    // resumes the dynamic layout, which is already running.
+    if(watch)
+    {
+        resetNavigationCallback(0);
+    }
+}
+
 void Mycelia::resetLayout(bool watch)
 {
     stopLayout();
     bundleButton->setToggle(false);
+    densityBundleButton->setToggle(false);
 
     // allow changing layout before graph is loaded
     if(staticButton->getToggle())
     {
         setLayoutType(LAYOUT_STATIC);
     }
+    else if(multilevelButton->getToggle())
+    {
+        setLayoutType(LAYOUT_MULTILEVEL);
+    }
+    else if(stressButton->getToggle())
+    {
+        setLayoutType(LAYOUT_STRESS);
+    }
+    else if(componentLayoutButton->getToggle())
+    {
+        setLayoutType(LAYOUT_COMPONENTS);
+    }
     else
     {
         setLayoutType(LAYOUT_DYNAMIC);
     }
 
-    // abort layout if no nodes, or positions hard coded in data
-    int size = g->getNodeCount();
+    // abort layout if no nodes, positions hard coded in data, or positions
+    // just restored from the layout cache
+    bool cached = cachedLayout;
+    cachedLayout = false;
 
-    if(skipLayout || size == 0)
+    if(skipLayout || cached || g->getNodeCount() == 0)
     {
         return;
     }
 
-    // reset layout state
-    g->randomizePositions(100);
-    g->clearVelocities();
+    bool warm = warmStart;
+    warmStart = false;
 
-    // In order to avoid a flicker during layout...let's recenter.
-    if (watch)
+    if(!acceleratedLayout)
     {
-        // Note, this will reset the dynamic layout since it calls
-        // resumeLayout(). Fortunately, the call to startLayout() (below)
-        // is smart enough to handle this and not restart the thread.
-        resetNavigationCallback(0);
+        // placement can take seconds on large graphs, the layout thread
+        // does it before its first step
+        placementMutex.lock();
+        placementLayout = layout;
+        placementWarm = warm;
+        placementWatch = watch;
+        placementMutex.unlock();
+
+        // Some layouts will automatically call resetNavigationCallback once
+        // they have finished laying out the graph.
+        startLayout();
+        return;
+    }
+
+    placeNodes(warm);
+
+    // arrays are indexed by position in the node list
+    vector<int> nodes = g->getNodes();
+    int size = nodes.size();
+    vector<int> index(g->getNodeCapacity(), -1);
+
+    for(int i = 0; i < size; i++)
+    {
+        index[nodes[i]] = i;
     }
 
-#ifndef __CUDA__
-    // Some layouts will automatically call resetNavigationCallback once
-    // they have finished laying out the graph.
-    startLayout();
-#else
     // positions
     float4* positions_h = new float4[size];
 
-    foreach(int node, g->getNodes())
+    for(int i = 0; i < size; i++)
     {
-        const Vrui::Point& p = g->getNodePosition(node);
+        const Vrui::Point& p = g->getNodePosition(nodes[i]);
         float4 q;
         q.x = p[0];
         q.y = p[1];
         q.z = p[2];
-        q.w = g->getNodeDegree(node);
-        positions_h[node] = q;
+        q.w = g->getNodeDegree(nodes[i]);
+        positions_h[i] = q;
     }
 
-    // adjacency matrix
-    int* adjacencies_h = new int[size * size];
+    // adjacency lists, parallel edges count once per direction
+    vector<int> offsets(size + 1, 0);
+    vector<int> neighbors;
+    neighbors.reserve(2 * g->getEdgeCount());
 
-    for(int row = 0; row < size; row++)
+    for(int i = 0; i < size; i++)
     {
-        for(int col = 0; col < size; col++)
+        int last = -1;
+
+        foreach(int edge, g->getOutEdges(nodes[i]))
+        {
+            int target = g->getEdge(edge).target;
+            if(target != last) neighbors.push_back(index[target]);
+            last = target;
+        }
+
+        last = -1;
+
+        foreach(int edge, g->getInEdges(nodes[i]))
         {
-            adjacencies_h[row * size + col] = g->hasEdge(row, col);
+            int source = g->getEdge(edge).source;
+            if(source != last) neighbors.push_back(index[source]);
+            last = source;
         }
+
+        offsets[i + 1] = neighbors.size();
     }
 
     // layout
-    gpuLayout(positions_h, adjacencies_h, size);
+    gpuLayout(positions_h, &offsets[0], neighbors.empty() ? 0 : &neighbors[0], size, threadPool);
 
     // update positions
-    foreach(int node, g->getNodes())
+    vector<Vrui::Point> positions(size);
+
+    for(int i = 0; i < size; i++)
     {
-        const float4& q = positions_h[node];
-        g->setNodePosition(node, Vrui::Point(q.x, q.y, q.z));
+        const float4& q = positions_h[i];
+        positions[i] = Vrui::Point(q.x, q.y, q.z);
     }
 
+    g->setNodePositions(nodes, positions);
+
     // free memory
     delete[] positions_h;
-    delete[] adjacencies_h;
 
     resetNavigationCallback(0);
-#endif
 }
 
 void Mycelia::resetNavigationCallback(Misc::CallbackData* cbData)
@@ -1257,7 +1795,7 @@ void Mycelia::resetNavigationCallback(Misc::CallbackData* cbData)
 
     Vrui::setNavigationTransformation(Vrui::Point::origin, radius);
 
-    g->update();
+    g->redraw();
     if (layoutWasRunning)
     {
         resumeLayout(); // for dynamic layout
@@ -1300,7 +1838,7 @@ void Mycelia::writeGraphCallback(Misc::CallbackData* cbData)
 void Mycelia::clearSelections()
 {
     previousNode = selectedNode = SELECTION_NONE;
-    g->update();
+    g->redraw();
 }
 
 int Mycelia::getPreviousNode() const
@@ -1330,7 +1868,7 @@ void Mycelia::setSelectedNode(int node)
     selectedNode = node;
 
     shortestPathCallback(0);
-    g->update();
+    g->redraw();
 #ifdef __RPCSERVER__
     server->callback(node);
 #endif
@@ -1341,7 +1879,7 @@ void Mycelia::setHighlightedNode(int node)
     if (node != highlightedNode)
     {
         highlightedNode = node;
-        g->update();
+        g->redraw();
     }
 }
 
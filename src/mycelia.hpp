@@ -26,6 +26,7 @@ class ArfWindow;
 class AttributeWindow;
 class BarabasiGenerator;
 class ChacoParser;
+class ComponentLayout;
 class DotParser;
 class Edge;
 class EdgeBundler;
@@ -36,19 +37,73 @@ class Graph;
 class GraphGenerator;
 class GraphLayout;
 class ImageWindow;
+class LayoutCache;
+class MultilevelLayout;
 class MyceliaDataItem;
+class PivotMds;
+class PositionBuffer;
 class RpcServer;
+class StressLayout;
+class ThreadPool;
 class XmlParser;
 class WattsGenerator;
 
 #define LAYOUT_STATIC 0
 #define LAYOUT_DYNAMIC 1
+#define LAYOUT_MULTILEVEL 2
+#define LAYOUT_STRESS 3
+#define LAYOUT_COMPONENTS 4
 #define SELECTION_NONE -1
 #define FONT_SIZE 96.0
 #define FONT_MODIFIER 0.04
 #define foreach BOOST_FOREACH
 #define PYTHON "/usr/bin/python"
 
+#ifdef __HEADLESS__
+
+#include <Threads/Cond.h>
+
+/*
+ * Stand-in for the application in the batch layout tool, built without a
+ * window or GL. Parsers and layouts see the members they use; nothing is
+ * selected, so every node is laid out. Defined in batchlayout.cpp.
+ */
+class Mycelia
+{
+private:
+    mutable Threads::Mutex finishedMutex;
+    mutable Threads::Cond finishedCond;
+    mutable bool finished;
+    bool skipLayout;
+
+public:
+    Mycelia(int);
+    ~Mycelia();
+
+    // layout functions
+    void layoutFinished() const;
+    void layoutSettled() const;
+    void placeLayout(const GraphLayout*) {}
+    void resetNavigationCallback(Misc::CallbackData*) {}
+    const bool getSkipLayout() const { return skipLayout; }
+    void setSkipLayout(bool s) { skipLayout = s; }
+    void stopLayout() const {}
+    void wakeLayout() const {}
+    void waitForLayout() const;
+
+    // node selection
+    void clearSelections() {}
+    int getPreviousNode() const { return SELECTION_NONE; }
+    int getSelectedNode() const { return SELECTION_NONE; }
+    bool isSelectedComponent(int) const { return true; }
+
+    Graph* g;
+    PositionBuffer* positionBuffer; // layout -> nobody
+    ThreadPool* threadPool;
+};
+
+#else
+
 class Mycelia : public Vrui::Application, public GLObject
 {
 private:
@@ -62,9 +117,27 @@ private:
     // layout and bundling
     FruchtermanReingoldLayout* staticLayout;
     ArfLayout* dynamicLayout;
+    MultilevelLayout* multilevelLayout;
+    StressLayout* stressLayout;
+    ComponentLayout* componentLayout;
     GraphLayout* layout;
     EdgeBundler* edgeBundler;
+    PivotMds* pivotMds; // initial placement
+    LayoutCache* layoutCache;
+    std::string cacheSource; // file the graph came from, empty if none
+    mutable Threads::Mutex cacheSourceMutex; // layout threads read cacheSource
     bool skipLayout;
+    bool warmStart; // positions came from a near hit in the layout cache
+    bool cachedLayout; // positions came from an exact hit, the next reset keeps them
+    bool acceleratedLayout; // reset runs gpuLayout instead of starting the layout
+
+    // placement a reset left for the layout's own thread
+    Threads::Mutex placementMutex;
+    const GraphLayout* placementLayout; // 0 if none pending
+    bool placementWarm;
+    bool placementWatch;
+
+    const bool placeNodes(bool);
 
     // gui
     GLMotif::Menu* mainMenu;
@@ -80,9 +153,13 @@ private:
     GLMotif::RadioBox* layoutRadioBox;
     GLMotif::ToggleButton* staticButton;
     GLMotif::ToggleButton* dynamicButton;
+    GLMotif::ToggleButton* multilevelButton;
+    GLMotif::ToggleButton* stressButton;
+    GLMotif::ToggleButton* componentLayoutButton;
 
     // gui -- render options
     GLMotif::ToggleButton* bundleButton;
+    GLMotif::ToggleButton* densityBundleButton;
     GLMotif::ToggleButton* nodeInfoButton;
     GLMotif::ToggleButton* nodeLabelButton;
     GLMotif::ToggleButton* edgeLabelButton;
@@ -130,6 +207,8 @@ private:
     int selectedNode;
     int previousNode;
     int highlightedNode;
+    int renderVersion; // bumped whenever gCopy changes
+    int graphVersion; // bumped when gCopy changes other than by layout motion
     float coneAngle;
     Vrui::Vector rightVector;
     Vrui::Vector upVector;
@@ -143,7 +222,9 @@ public:
     ~Mycelia();
 
     // graph functions
+    void buildBuffers(MyceliaDataItem*) const;
     void buildGraphList(MyceliaDataItem*) const;
+    void drawBuffers(MyceliaDataItem*) const;
     void drawEdge(const Edge&, MyceliaDataItem*) const;
     void drawEdge(const Vrui::Point&, const Vrui::Point&,
                   const GLMaterial*, const Vrui::Scalar, bool, bool,
@@ -160,16 +241,24 @@ public:
     void drawShortestPath(MyceliaDataItem*) const;
     void drawSpanningTree(MyceliaDataItem*) const;
     void fileOpen(std::string &filename);
+    void fillBuffers(MyceliaDataItem*) const;
     double getNodeEdgeOffset(int node, MyceliaDataItem*) const;
+    const GLMaterial* getShapeNodeMaterial(int) const;
     bool isSelectedComponent(int) const;
 
     // layout functions
+    void getLayoutParameters(std::vector<double>&) const;
+    void layoutFinished() const;
+    void layoutSettled() const;
+    void placeLayout(const GraphLayout*);
     void resetLayout(bool watch=true);
     void resumeLayout() const;
+    void setCacheSource(const std::string&);
     void setLayoutType(int);
     void setSkipLayout(bool);
     void startLayout() const;
     void stopLayout() const;
+    void wakeLayout() const;
     bool layoutIsStopped() const;
 
     // vrui functions
@@ -225,9 +314,13 @@ public:
     // other
     Graph* g; // wrap this eventually
     Graph* gCopy;
+    PositionBuffer* positionBuffer; // layout -> renderer
+    ThreadPool* threadPool; // shared by the layouts
     GLMotif::PopupMenu* getMainMenuPopup() { return mainMenuPopup; }
     ArfLayout* getDynamicLayout() { return dynamicLayout; }
     void setStatus(const char*) const;
 };
 
 #endif
+
+#endif
@@ -34,11 +34,12 @@ void ChacoParser::parse(string& filename)
     in >> nodeCount >> edgeCount;
     cout << nodeCount << " nodes, " << edgeCount << " edges" << endl;
     
-    for(int i = 0; i < nodeCount; i++)
-    {
-        application->g->addNode();
-    }
+    // each undirected edge is listed from both ends
+    application->g->reserve(nodeCount, 2 * edgeCount);
+    application->g->addNodes(nodeCount);
     
+    vector<pair<int, int> > edges;
+    edges.reserve(2 * edgeCount);
     int sourceNode = 0;
     
     while(!in.eof())
@@ -51,11 +52,12 @@ void ChacoParser::parse(string& filename)
         
         while(stream >> targetNode) // only works because space is delimiter
         {
-            application->g->addEdge(sourceNode, targetNode);
+            edges.push_back(pair<int, int>(sourceNode, targetNode));
         }
         
         sourceNode++;
     }
     
     in.close();
+    application->g->addEdges(edges);
 }
\ No newline at end of file
@@ -46,14 +46,22 @@ void DotParser::parse(string& filename)
     smatch labelMatches;
     nodeMap.clear();
     
-    // nodes
+    // nodes -- collect names, positions and labels, then add in one batch
     lineStart = fileBuffer.begin();
     lineEnd = fileBuffer.end();
+    vector<string> names;
+    map<string, Vrui::Point> positionMap;
+    map<string, string> labelMap;
     
     while(regex_search(lineStart, lineEnd, lineMatches, nodeRegex))
     {
         string nodeId(lineMatches[1].first,  lineMatches[1].second);
-        nodeMap[nodeId] = application->g->addNode();
+        
+        if(nodeMap.find(nodeId) == nodeMap.end())
+        {
+            nodeMap[nodeId] = names.size();
+            names.push_back(nodeId);
+        }
         
         string::const_iterator posStart = lineMatches[1].second; // end of node name
         string::const_iterator posEnd = lineMatches[0].second;; // end of line
@@ -68,7 +76,7 @@ void DotParser::parse(string& filename)
             float y = VruiHelp::stringToFloat(sy);
             float z = VruiHelp::stringToFloat(sz);
             
-            application->g->setNodePosition(nodeMap[nodeId], Vrui::Point(x, y, z));
+            positionMap[nodeId] = Vrui::Point(x, y, z);
             application->setSkipLayout(true);
         }
         
@@ -77,16 +85,18 @@ void DotParser::parse(string& filename)
         
         if(regex_search(labelStart, labelEnd, labelMatches, labelRegex))
         {
-            string label(labelMatches[1].first, labelMatches[1].second);
-            application->g->setNodeLabel(nodeMap[nodeId], label);
+            labelMap[nodeId] = string(labelMatches[1].first, labelMatches[1].second);
         }
         
         lineStart = lineMatches[0].second;
     }
     
-    // edges
+    // edges -- endpoints not declared as nodes are labeled with their name
     lineStart = fileBuffer.begin();
     lineEnd = fileBuffer.end();
+    vector<pair<string, string> > edgeNames;
+    vector<int> labeledEdges;
+    vector<string> edgeLabels;
     
     while(regex_search(lineStart, lineEnd, lineMatches, edgeRegex))
     {
@@ -95,24 +105,74 @@ void DotParser::parse(string& filename)
         
         if(nodeMap.find(source) == nodeMap.end())
         {
-            nodeMap[source] = application->g->addNode(source);
+            nodeMap[source] = names.size();
+            names.push_back(source);
+            labelMap[source] = source;
         }
         
         if(nodeMap.find(target) == nodeMap.end())
         {
-            nodeMap[target] = application->g->addNode(target);
+            nodeMap[target] = names.size();
+            names.push_back(target);
+            labelMap[target] = target;
         }
         
-        int edgeId = application->g->addEdge(nodeMap[source], nodeMap[target]);
         string::const_iterator labelStart = lineMatches[1].second; // end of transition
         string::const_iterator labelEnd = lineMatches[0].second;; // end of line
         
         if(regex_search(labelStart, labelEnd, labelMatches, labelRegex))
         {
-            string label(labelMatches[1].first, labelMatches[1].second);
-            application->g->setEdgeLabel(edgeId, label);
+            labeledEdges.push_back(edgeNames.size());
+            edgeLabels.push_back(string(labelMatches[1].first, labelMatches[1].second));
         }
         
+        edgeNames.push_back(pair<string, string>(source, target));
         lineStart = lineMatches[0].second;
     }
+    
+    // add everything, nodeMap goes from file order to graph ids
+    application->g->reserve(names.size(), edgeNames.size());
+    vector<int> nodes = application->g->addNodes(names.size());
+    
+    for(int i = 0; i < (int)names.size(); i++)
+    {
+        nodeMap[names[i]] = nodes[i];
+    }
+    
+    vector<int> positionNodes;
+    vector<Vrui::Point> positions;
+    
+    for(map<string, Vrui::Point>::iterator i = positionMap.begin(); i != positionMap.end(); i++)
+    {
+        positionNodes.push_back(nodeMap[i->first]);
+        positions.push_back(i->second);
+    }
+    
+    vector<int> labelNodes;
+    vector<string> labels;
+    
+    for(map<string, string>::iterator i = labelMap.begin(); i != labelMap.end(); i++)
+    {
+        labelNodes.push_back(nodeMap[i->first]);
+        labels.push_back(i->second);
+    }
+    
+    application->g->setNodePositions(positionNodes, positions);
+    application->g->setNodeLabels(labelNodes, labels);
+    
+    vector<pair<int, int> > edgePairs(edgeNames.size());
+    
+    for(int i = 0; i < (int)edgeNames.size(); i++)
+    {
+        edgePairs[i] = pair<int, int>(nodeMap[edgeNames[i].first], nodeMap[edgeNames[i].second]);
+    }
+    
+    vector<int> edges = application->g->addEdges(edgePairs);
+    
+    for(int i = 0; i < (int)labeledEdges.size(); i++)
+    {
+        labeledEdges[i] = edges[labeledEdges[i]];
+    }
+    
+    application->g->setEdgeLabels(labeledEdges, edgeLabels);
 }
\ No newline at end of file
@@ -28,6 +28,8 @@ GmlParser::GmlParser(Mycelia* application)
 void GmlParser::parse(string& filename)
 {
     ifstream in(filename.c_str());
+    int nodeCount = 0;
+    vector<pair<int, int> > edges;
     
     while(!in.eof())
     {
@@ -40,7 +42,7 @@ void GmlParser::parse(string& filename)
         
         if(token == "id")
         {
-            application->g->addNode();
+            nodeCount++;
         }
         else if(token == "source")
         {
@@ -54,9 +56,13 @@ void GmlParser::parse(string& filename)
             
             if(token == "target")
             {
-                application->g->addEdge(source, target);
+                edges.push_back(pair<int, int>(source, target));
                 cout << source << " -> " << target << endl;
             }
         }
     }
+    
+    application->g->reserve(nodeCount, edges.size());
+    application->g->addNodes(nodeCount);
+    application->g->addEdges(edges);
 }
\ No newline at end of file
@@ -92,15 +92,22 @@ void XmlParser::parse(string& filename)
     
     std::sort(addList.begin(), addList.end());
     
-    foreach(int xmlId, addList)
+    vector<int> graphIds = application->g->addNodes(addList.size());
+    
+    for(int i = 0; i < (int)addList.size(); i++)
     {
-        int graphId = application->g->addNode();
-        idMap[xmlId] = graphId;
+        idMap[addList[i]] = graphIds[i];
     }
     
-    // nodes -- add attributes
+    // nodes -- collect attributes, then set them in one batch
     lineStart = fileBuffer.begin();
     lineEnd = fileBuffer.end();
+    vector<int> colorNodes;
+    vector<GLMaterial::Color> colors;
+    vector<int> labelNodes;
+    vector<string> labels;
+    vector<int> attributeNodes;
+    vector<Attributes> attributes;
     
     while(regex_search(lineStart, lineEnd, lineMatches, nodeRegex))
     {
@@ -117,27 +124,45 @@ void XmlParser::parse(string& filename)
             if(key == "id")
             {
                 xmlId = VruiHelp::stringToInt(value);
+                attributeNodes.push_back(idMap[xmlId]);
+                attributes.push_back(Attributes());
+            }
+            else if(xmlId == -1)
+            {
+                // no node to attach to until its id is seen
+                nodeStart = attributeMatches[0].second;
+                continue;
             }
             else if(key == colorKey)
             {
                 vector<int>& rgba = colorMap[value];
-                application->g->setNodeColor(idMap[xmlId], rgba[0], rgba[1], rgba[2], rgba[3]);
+                colorNodes.push_back(idMap[xmlId]);
+                colors.push_back(GLMaterial::Color(rgba[0] / 255.0, rgba[1] / 255.0, rgba[2] / 255.0, rgba[3] / 255.0));
             }
             else if(key == "label")
             {
-                application->g->setNodeLabel(idMap[xmlId], value);
+                labelNodes.push_back(idMap[xmlId]);
+                labels.push_back(value);
             }
             
-            application->g->setNodeAttribute(idMap[xmlId], key, value);
+            attributes.back().push_back(pair<string, string>(key, value));
+            
             nodeStart = attributeMatches[0].second;
         }
         
         lineStart = lineMatches[0].second;
     }
     
-    // edges
+    application->g->setNodeColors(colorNodes, colors);
+    application->g->setNodeLabels(labelNodes, labels);
+    application->g->setNodeAttributes(attributeNodes, attributes);
+    
+    // edges -- labels refer to positions in edgePairs until the edges exist
     lineStart = fileBuffer.begin();
     lineEnd = fileBuffer.end();
+    vector<pair<int, int> > edgePairs;
+    vector<int> labeledEdges;
+    vector<string> edgeLabels;
     
     while(regex_search(lineStart, lineEnd, lineMatches, edgeRegex))
     {
@@ -145,8 +170,9 @@ void XmlParser::parse(string& filename)
         string::const_iterator edgeEnd = lineMatches[1].second;
         int source = -1;
         int target = -1;
-        int edgeId = -1;
         bool directed = true;
+        bool labeled = false;
+        string label;
         
         // loop through attributes
         while(regex_search(edgeStart, edgeEnd, attributeMatches, keyvalueRegex))
@@ -161,7 +187,6 @@ void XmlParser::parse(string& filename)
             else if(key == "to")
             {
                 target = VruiHelp::stringToInt(value);
-                edgeId = application->g->addEdge(idMap[source], idMap[target]);
             }
             else if(key == "directed" && value == "false")
             {
@@ -169,13 +194,34 @@ void XmlParser::parse(string& filename)
             }
             else if(key == "label")
             {
-                application->g->setEdgeLabel(edgeId, value);
+                labeled = true;
+                label = value;
             }
             
             edgeStart = attributeMatches[0].second;
         }
         
-        if(!directed) application->g->addEdge(idMap[target], idMap[source]);
+        if(target != -1)
+        {
+            if(labeled)
+            {
+                labeledEdges.push_back(edgePairs.size());
+                edgeLabels.push_back(label);
+            }
+            
+            edgePairs.push_back(pair<int, int>(idMap[source], idMap[target]));
+            if(!directed) edgePairs.push_back(pair<int, int>(idMap[target], idMap[source]));
+        }
+        
         lineStart = lineMatches[0].second;
     }
+    
+    vector<int> edges = application->g->addEdges(edgePairs);
+    
+    for(int i = 0; i < (int)labeledEdges.size(); i++)
+    {
+        labeledEdges[i] = edges[labeledEdges[i]];
+    }
+    
+    application->g->setEdgeLabels(labeledEdges, edgeLabels);
 }
\ No newline at end of file
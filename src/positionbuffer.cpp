@@ -0,0 +1,79 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <positionbuffer.hpp>
+
+#define FRESH 4
+
+PositionBuffer::PositionBuffer()
+    : back(0),
+      front(1),
+      middle(2)
+{
+    for(int i = 0; i < 3; i++)
+    {
+        slots[i].count = 0;
+        slots[i].tag = -1;
+    }
+}
+
+float* PositionBuffer::beginWrite(int count)
+{
+    Slot& slot = slots[back];
+    slot.positions.resize(count * 3);
+    slot.count = count;
+
+    return count > 0 ? &slot.positions[0] : 0;
+}
+
+void PositionBuffer::publish(int tag)
+{
+    slots[back].tag = tag;
+
+    // make the slot contents visible before handing it over
+    __sync_synchronize();
+    back = __sync_lock_test_and_set(&middle, back | FRESH) & ~FRESH;
+}
+
+bool PositionBuffer::acquire()
+{
+    if(!(middle & FRESH))
+    {
+        return false;
+    }
+
+    front = __sync_lock_test_and_set(&middle, front) & ~FRESH;
+    __sync_synchronize();
+
+    return true;
+}
+
+const float* PositionBuffer::getPositions() const
+{
+    return slots[front].count > 0 ? &slots[front].positions[0] : 0;
+}
+
+int PositionBuffer::getCount() const
+{
+    return slots[front].count;
+}
+
+int PositionBuffer::getTag() const
+{
+    return slots[front].tag;
+}
@@ -0,0 +1,59 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __POSITIONBUFFER_HPP
+#define __POSITIONBUFFER_HPP
+
+#include <vector>
+
+/*
+ * Single producer, single consumer triple buffer of packed xyz positions.
+ * The layout fills the back slot and publishes it; the renderer takes the
+ * newest published slot. Neither side ever waits on the other, and the
+ * consumer always sees a complete frame.
+ */
+class PositionBuffer
+{
+private:
+    struct Slot
+    {
+        std::vector<float> positions;
+        int count; // nodes in this frame
+        int tag; // graph version the frame belongs to
+    };
+
+    Slot slots[3];
+    int back; // owned by the producer
+    int front; // owned by the consumer
+    volatile int middle; // slot index, FRESH set if not yet consumed
+
+public:
+    PositionBuffer();
+
+    // producer
+    float* beginWrite(int count);
+    void publish(int tag);
+
+    // consumer, true if a newer frame was taken
+    bool acquire();
+    const float* getPositions() const;
+    int getCount() const;
+    int getTag() const;
+};
+
+#endif
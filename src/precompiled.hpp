@@ -2,11 +2,13 @@
 #define __PRECOMPILED_HPP
 
 // vrui
+#include <GL/Extensions/GLARBVertexBufferObject.h>
 #include <GL/GLContextData.h>
 #include <GL/GLGeometryWrappers.h>
 #include <GL/GLMaterial.h>
 #include <GL/GLModels.h>
 #include <GL/GLObject.h>
+#include <GL/GLShader.h>
 #include <GL/GLTransformationWrappers.h>
 #include <GLMotif/Button.h>
 #include <GLMotif/CascadeButton.h>
@@ -39,6 +41,7 @@
 #include <boost/graph/prim_minimum_spanning_tree.hpp>
 #include <boost/foreach.hpp>
 #include <boost/regex.hpp>
+#include <boost/shared_ptr.hpp>
 
 // font rendering
 #include <FTGL/ftgl.h>
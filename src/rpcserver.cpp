@@ -29,12 +29,16 @@ RpcServer::RpcServer(Mycelia* app) : app(app)
 
 void* RpcServer::run()
 {
+    VruiHelp::setRandomStream(RANDOM_STREAM_RPC);
+
     xmlrpc_c::registry r;
 
+    r.addMethod("begin", new Begin(app));
     r.addMethod("center", new Center(app));
     r.addMethod("clear", new Clear(app));
     r.addMethod("clear_edges", new ClearEdges(app));
     r.addMethod("clear_velocities", new ClearVelocities(app));
+    r.addMethod("commit", new Commit(app));
     r.addMethod("delete_edge", new DeleteEdge(app));
     r.addMethod("delete_node", new DeleteNode(app));
     r.addMethod("draw", new Draw(app));
@@ -57,8 +61,11 @@ void* RpcServer::run()
     r.addMethod("set_node_type", new SetNodeType(app));
     r.addMethod("set_node_image_path", new SetNodeImagePath(app));
     r.addMethod("set_node_image_scale", new SetNodeImageScale(app));    
+    r.addMethod("set_seed", new SetSeed(app));
+    r.addMethod("set_settled_callback", new SetSettledCallback(app, this));
     r.addMethod("set_status", new SetStatus(app));
     r.addMethod("set_texture_node_mode", new SetTextureNodeMode(app));
+    r.addMethod("set_thread_count", new SetThreadCount(app));
     r.addMethod("start_layout", new StartLayout(app));
     r.addMethod("stop_layout", new StopLayout(app));
 
@@ -84,3 +91,35 @@ void RpcServer::setCallback(const string& url, const string& method)
     callbackUrl = url;
     callbackMethod = method;
 }
+
+void RpcServer::setSettledCallback(const string& url, const string& method)
+{
+    settledMutex.lock();
+    settledUrl = url;
+    settledMethod = method;
+    settledMutex.unlock();
+}
+
+// Tells the client the dynamic layout has come to rest. Runs on the layout
+// thread, so a failed call is reported rather than thrown.
+void RpcServer::settled()
+{
+    settledMutex.lock();
+    string url = settledUrl;
+    string method = settledMethod;
+    settledMutex.unlock();
+
+    if(!Vrui::isMaster() || url.size() == 0 || method.size() == 0) return;
+
+    xmlrpc_c::value settledResult;
+    xmlrpc_c::paramList params;
+
+    try
+    {
+        settledClient.call(url, method, params, &settledResult);
+    }
+    catch(std::exception& e)
+    {
+        cout << "settled callback to " << url << " failed: " << e.what() << endl;
+    }
+}
\ No newline at end of file
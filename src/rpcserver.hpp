@@ -21,6 +21,8 @@
 
 #include <graph.hpp>
 #include <mycelia.hpp>
+#include <threadpool.hpp>
+#include <vruihelp.hpp>
 
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/client_simple.hpp>
@@ -35,6 +37,10 @@ private:
     std::string callbackUrl;
     std::string callbackMethod;
     xmlrpc_c::clientSimple callbackClient;
+    std::string settledUrl;
+    std::string settledMethod;
+    Threads::Mutex settledMutex; // set by the server thread, read by the layout thread
+    xmlrpc_c::clientSimple settledClient; // used from the layout thread
     int port;
 
 public:
@@ -43,6 +49,8 @@ public:
     void* run();
     void callback(int);
     void setCallback(const std::string&, const std::string&);
+    void setSettledCallback(const std::string&, const std::string&);
+    void settled();
 };
 
 class AddEdge : public xmlrpc_c::method
@@ -58,6 +66,7 @@ public:
         int target = params.getInt(1);
         params.verifyEnd(2);
 
+        app->setCacheSource("");
         int edge = app->g->addEdge(source, target);
 
         *retval = xmlrpc_c::value_int(edge);
@@ -73,6 +82,7 @@ public:
 
     void execute(const xmlrpc_c::paramList& params, xmlrpc_c::value* retval)
     {
+        app->setCacheSource("");
         int node = app->g->addNode();
 
         *retval = xmlrpc_c::value_int(node);
@@ -93,6 +103,7 @@ public:
         double z = params.getDouble(2);
         params.verifyEnd(3);
 
+        app->setCacheSource("");
         Vrui::Point p(x,y,z);
         app->g->addNode(p);
 
@@ -101,6 +112,21 @@ public:
 };
 
 
+class Begin : public xmlrpc_c::method
+{
+    Mycelia* app;
+
+public:
+    Begin(Mycelia* app) : app(app) {}
+
+    void execute(const xmlrpc_c::paramList& params, xmlrpc_c::value* retval)
+    {
+        app->g->begin();
+
+        *retval = xmlrpc_c::value_int(0);
+    }
+};
+
 class Center : public xmlrpc_c::method
 {
     Mycelia* app;
@@ -125,6 +151,8 @@ public:
 
     void execute(const xmlrpc_c::paramList& params, xmlrpc_c::value* retval)
     {
+        // streamed graphs are not cached under the last opened file
+        app->setCacheSource("");
         app->g->clear();
 
         *retval = xmlrpc_c::value_int(0);
@@ -140,6 +168,7 @@ public:
 
     void execute(const xmlrpc_c::paramList& params, xmlrpc_c::value* retval)
     {
+        app->setCacheSource("");
         app->g->clearEdges();
 
         *retval = xmlrpc_c::value_int(0);
@@ -161,6 +190,21 @@ public:
     }
 };
 
+class Commit : public xmlrpc_c::method
+{
+    Mycelia* app;
+
+public:
+    Commit(Mycelia* app) : app(app) {}
+
+    void execute(const xmlrpc_c::paramList& params, xmlrpc_c::value* retval)
+    {
+        app->g->commit();
+
+        *retval = xmlrpc_c::value_int(0);
+    }
+};
+
 class Draw : public xmlrpc_c::method
 {
     Mycelia* app;
@@ -170,7 +214,7 @@ public:
 
     void execute(const xmlrpc_c::paramList& params, xmlrpc_c::value* retval)
     {
-        app->g->update();
+        app->g->redraw();
 
         *retval = xmlrpc_c::value_int(0);
     }
@@ -189,6 +233,7 @@ public:
         int edge = params.getInt(0);
         params.verifyEnd(1);
 
+        app->setCacheSource("");
         *retval = xmlrpc_c::value_int(app->g->deleteEdge(edge));
     }
 };
@@ -205,6 +250,7 @@ public:
         int node = params.getInt(0);
         params.verifyEnd(1);
 
+        app->setCacheSource("");
         *retval = xmlrpc_c::value_int(app->g->deleteNode(node));
     }
 };
@@ -510,6 +556,23 @@ public:
     }
 };
 
+class SetSettledCallback : public xmlrpc_c::method
+{
+    Mycelia* app;
+    RpcServer* server;
+
+public:
+    SetSettledCallback(Mycelia* app, RpcServer* server) : app(app), server(server) {}
+
+    void execute(const xmlrpc_c::paramList& params, xmlrpc_c::value* retval)
+    {
+        server->setSettledCallback(params.getString(0), params.getString(1));
+        params.verifyEnd(2);
+
+        *retval = xmlrpc_c::value_int(0);
+    }
+};
+
 class SetTextureNodeMode : public xmlrpc_c::method
 {
     Mycelia* app;
@@ -545,6 +608,59 @@ public:
     }
 };
 
+class SetSeed : public xmlrpc_c::method
+{
+    Mycelia* app;
+
+public:
+    SetSeed(Mycelia* app) : app(app) {}
+
+    void execute(const xmlrpc_c::paramList& params, xmlrpc_c::value* retval)
+    {
+        // 64 bit seeds come as i8 or as a decimal string
+        unsigned long long seed;
+
+        if(params[0].type() == xmlrpc_c::value::TYPE_STRING)
+        {
+            seed = strtoull(params.getString(0).c_str(), 0, 10);
+        }
+        else if(params[0].type() == xmlrpc_c::value::TYPE_I8)
+        {
+            seed = params.getI8(0);
+        }
+        else
+        {
+            seed = params.getInt(0);
+        }
+
+        params.verifyEnd(1);
+
+        VruiHelp::seedRandom(seed);
+
+        *retval = xmlrpc_c::value_int(0);
+    }
+};
+
+class SetThreadCount : public xmlrpc_c::method
+{
+    Mycelia* app;
+
+public:
+    SetThreadCount(Mycelia* app) : app(app) {}
+
+    void execute(const xmlrpc_c::paramList& params, xmlrpc_c::value* retval)
+    {
+        int count = params.getInt(0);
+        params.verifyEnd(1);
+
+        app->stopLayout();
+        app->threadPool->setThreadCount(count);
+        app->resumeLayout();
+
+        *retval = xmlrpc_c::value_int(0);
+    }
+};
+
 class StartLayout  : public xmlrpc_c::method
 {
     Mycelia* app;
@@ -0,0 +1,222 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <threadpool.hpp>
+#include <vruihelp.hpp>
+
+#include <unistd.h>
+
+using namespace std;
+
+ThreadPool::ThreadPool(int threadCount)
+    : generation(0),
+      startGeneration(0),
+      pending(0),
+      nextWorker(1),
+      quit(false),
+      task(0),
+      count(0),
+      grain(1)
+{
+    startThreads(threadCount);
+}
+
+ThreadPool::~ThreadPool()
+{
+    stopThreads();
+}
+
+const int ThreadPool::getDefaultThreadCount()
+{
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? cpus : 1;
+}
+
+void ThreadPool::setThreadCount(int threadCount)
+{
+    runMutex.lock();
+
+    stopThreads();
+    startThreads(threadCount);
+
+    runMutex.unlock();
+}
+
+void ThreadPool::startThreads(int threadCount)
+{
+    int limit = THREADS_PER_CORE * getDefaultThreadCount();
+
+    if(threadCount > limit)
+    {
+        cout << "thread count " << threadCount << " limited to " << limit << endl;
+        threadCount = limit;
+    }
+
+    if(threadCount < 1) threadCount = 1;
+
+    quit = false;
+    nextWorker = 1;
+    startGeneration = generation;
+
+    for(int i = 0; i < threadCount; i++)
+    {
+        queues.push_back(new Queue());
+        queues.back()->begin = queues.back()->end = 0;
+    }
+
+    // the calling thread is worker 0
+    for(int i = 1; i < threadCount; i++)
+    {
+        Threads::Thread* thread = new Threads::Thread();
+        thread->start(this, &ThreadPool::workerMain);
+        threads.push_back(thread);
+    }
+}
+
+void ThreadPool::stopThreads()
+{
+    mutex.lock();
+    quit = true;
+    startCond.broadcast();
+    mutex.unlock();
+
+    foreach(Threads::Thread* thread, threads)
+    {
+        thread->join();
+        delete thread;
+    }
+
+    foreach(Queue* queue, queues)
+    {
+        delete queue;
+    }
+
+    threads.clear();
+    queues.clear();
+}
+
+void ThreadPool::parallelFor(int items, int itemsPerChunk, Task& t)
+{
+    if(items <= 0) return;
+
+    runMutex.lock();
+
+    int workers = queues.size();
+    int chunks = getChunkCount(items, itemsPerChunk);
+
+    for(int w = 0; w < workers; w++)
+    {
+        queues[w]->begin = (long)chunks * w / workers;
+        queues[w]->end = (long)chunks * (w + 1) / workers;
+    }
+
+    mutex.lock();
+    task = &t;
+    count = items;
+    grain = itemsPerChunk;
+    pending = workers - 1;
+    generation++;
+    startCond.broadcast();
+    mutex.unlock();
+
+    work(0);
+
+    mutex.lock();
+
+    while(pending > 0)
+    {
+        doneCond.wait(mutex);
+    }
+
+    task = 0;
+    mutex.unlock();
+
+    runMutex.unlock();
+}
+
+void* ThreadPool::workerMain()
+{
+    int worker = __sync_fetch_and_add(&nextWorker, 1);
+    VruiHelp::setRandomStream(RANDOM_STREAM_WORKER + worker);
+
+    mutex.lock();
+    int seen = startGeneration;
+
+    while(true)
+    {
+        while(generation == seen && !quit)
+        {
+            startCond.wait(mutex);
+        }
+
+        if(quit) break;
+
+        seen = generation;
+        mutex.unlock();
+
+        work(worker);
+
+        mutex.lock();
+
+        if(--pending == 0)
+        {
+            doneCond.signal();
+        }
+    }
+
+    mutex.unlock();
+    return 0;
+}
+
+// own block from the front, then steal from the back of the others
+const bool ThreadPool::take(int worker, int& chunk)
+{
+    int workers = queues.size();
+
+    for(int i = 0; i < workers; i++)
+    {
+        Queue& q = *queues[(worker + i) % workers];
+        bool found = false;
+
+        q.mutex.lock();
+
+        if(q.begin < q.end)
+        {
+            chunk = i == 0 ? q.begin++ : --q.end;
+            found = true;
+        }
+
+        q.mutex.unlock();
+
+        if(found) return true;
+    }
+
+    return false;
+}
+
+void ThreadPool::work(int worker)
+{
+    int chunk;
+
+    while(take(worker, chunk))
+    {
+        int begin = chunk * grain;
+        int end = min(count, begin + grain);
+        task->run(chunk, begin, end);
+    }
+}
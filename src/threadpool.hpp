@@ -0,0 +1,99 @@
+/*
+ * Mycelia immersive 3d network visualization tool.
+ * Copyright (C) 2008-2010 Sean Whalen.
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __THREADPOOL_HPP
+#define __THREADPOOL_HPP
+
+#include <mycelia.hpp>
+
+#include <Threads/Cond.h>
+
+#define THREADS_PER_CORE 4 // most threads a pool may be given per core
+
+/*
+ * Fixed set of worker threads for data parallel loops. parallelFor splits
+ * [0, count) into chunks of grain items and deals the chunks out in
+ * contiguous blocks, one block per worker. A worker that runs out takes
+ * chunks from the far end of another worker's block.
+ *
+ * Chunk boundaries depend only on count and grain, never on the number of
+ * threads or on scheduling. Tasks that write per item, or per chunk and
+ * reduce the chunks in order afterwards, give identical results for any
+ * thread count.
+ *
+ * One loop runs at a time. Loops from different threads, say the edge
+ * bundler and a layout, wait for each other on runMutex; each loop already
+ * spreads over every worker, so running them side by side would only split
+ * the same cores. Thread counts are capped at THREADS_PER_CORE per core.
+ */
+class ThreadPool
+{
+public:
+    class Task
+    {
+    public:
+        virtual ~Task() {}
+        virtual void run(int chunk, int begin, int end) = 0;
+    };
+
+private:
+    // chunks not yet taken from one worker's block
+    struct Queue
+    {
+        Threads::Mutex mutex;
+        int begin;
+        int end;
+    };
+
+    std::vector<Threads::Thread*> threads;
+    std::vector<Queue*> queues; // one per thread, plus the caller's at 0
+
+    Threads::Mutex runMutex; // one loop at a time
+    Threads::Mutex mutex;
+    Threads::Cond startCond;
+    Threads::Cond doneCond;
+    int generation;
+    int startGeneration; // generation when the threads were started
+    int pending;
+    int nextWorker;
+    bool quit;
+
+    Task* task;
+    int count;
+    int grain;
+
+    void* workerMain();
+    void work(int);
+    const bool take(int, int&);
+    void startThreads(int);
+    void stopThreads();
+
+public:
+    ThreadPool(int);
+    ~ThreadPool();
+
+    static const int getDefaultThreadCount();
+
+    const int getThreadCount() const { return queues.size(); }
+    void setThreadCount(int);
+
+    const int getChunkCount(int items, int grain) const { return (items + grain - 1) / grain; }
+    void parallelFor(int, int, Task&);
+};
+
+#endif
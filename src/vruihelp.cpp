@@ -110,10 +110,75 @@ string fileToString(string& filename)
     return stream.str();
 }
 
+/*
+ * random numbers
+ *
+ * Each thread draws from its own xoshiro256** state, so there is no lock
+ * to contend on. States are derived from one seed and the thread's role
+ * (main, rpc, layout or pool worker n), not from the order threads first
+ * draw in, so each role repeats its numbers for a given seed.
+ */
+static unsigned long long randomSeed = RANDOM_SEED;
+static volatile int randomGeneration = 1;
+
+static __thread unsigned long long randomState[4];
+static __thread int threadGeneration = 0;
+static __thread int threadStream = RANDOM_STREAM_MAIN;
+
+static unsigned long long splitmix(unsigned long long& x)
+{
+    unsigned long long z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+static inline unsigned long long rotl(unsigned long long x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
 float randomFloat()
 {
-    float x = rand() / (float(RAND_MAX) + 1);
-    return x;
+    unsigned long long* s = randomState;
+
+    if(threadGeneration != randomGeneration)
+    {
+        threadGeneration = randomGeneration;
+        unsigned long long x = randomSeed ^ ((unsigned long long)threadStream << 32);
+
+        for(int i = 0; i < 4; i++)
+        {
+            s[i] = splitmix(x);
+        }
+    }
+
+    unsigned long long result = rotl(s[1] * 5, 7) * 9;
+    unsigned long long t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+
+    // top 24 bits, exactly representable, in [0, 1)
+    return (result >> 40) * (1.0f / 16777216.0f);
+}
+
+// Restarts every thread's stream from the given seed.
+void seedRandom(unsigned long long seed)
+{
+    randomSeed = seed;
+    __sync_fetch_and_add(&randomGeneration, 1);
+}
+
+// Gives the calling thread the stream of its role, see RANDOM_STREAM_MAIN.
+void setRandomStream(int stream)
+{
+    threadStream = stream;
+    threadGeneration = 0;
 }
 
 void show(GLMotif::Widget* w)
@@ -21,6 +21,14 @@
 
 #include <mycelia.hpp>
 
+#define RANDOM_SEED 1 // used until seedRandom is called
+
+// random streams by thread role, pool workers add their index
+#define RANDOM_STREAM_MAIN 0
+#define RANDOM_STREAM_RPC 1
+#define RANDOM_STREAM_LAYOUT 2
+#define RANDOM_STREAM_WORKER 3
+
 typedef std::pair<GLMotif::TextField*, GLMotif::Slider*> ParamPair;
 
 namespace VruiHelp
@@ -39,6 +47,8 @@ float stringToFloat(std::string&);
 int stringToInt(std::string&);
 std::string fileToString(std::string&);
 float randomFloat();
+void seedRandom(unsigned long long);
+void setRandomStream(int);
 void show(GLMotif::Widget*);
 void show(GLMotif::Widget*, const GLMotif::Widget*);
 void hide(GLMotif::Widget*);